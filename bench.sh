@@ -0,0 +1,58 @@
+#!/bin/bash
+# Compares the end-to-end latency of --run with the default flags, -O2 and
+# --fast-compile on generated programs: a small one, a medium one with many
+# statements and a long-running one. Every time is the best of $RUNS runs of
+# the whole compiler. Compile-time evaluation is off, so that every tier
+# compiles and runs the program instead of writing its precomputed output.
+#
+# usage: ./bench.sh [path to gsm]    (default build/src/gsm)
+
+GSM=${1:-build/src/gsm}
+RUNS=${RUNS:-5}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+# Identifiers are letters only: v0 becomes va, v12 becomes vbc.
+NAMES='function name(i) { s = "v" i; gsub(/0/, "a", s); gsub(/1/, "b", s); gsub(/2/, "c", s);
+  gsub(/3/, "d", s); gsub(/4/, "e", s); gsub(/5/, "f", s); gsub(/6/, "g", s);
+  gsub(/7/, "h", s); gsub(/8/, "i", s); gsub(/9/, "j", s); return s }'
+
+# Groups of a declaration, an if/else and a short loop.
+program() {
+  awk -v N="$1" -v TRIPS="$2" "$NAMES"'
+  BEGIN {
+    for (i = 0; i < N; i++) {
+      v = name(i)
+      printf "int %s = %d;\n", v, i % 97
+      printf "if %s > 50: begin\n%s = %s * 2;\nend else: begin\n%s = %s + 3;\nend\n", v, v, v, v, v
+      printf "int %sx = 0;\n", v
+      printf "loopc %sx < %d: begin\n%s = %s %% 89 + %sx;\n%sx = %sx + 1;\nend\n", v, TRIPS, v, v, v, v, v
+    }
+  }'
+}
+
+program 10 100 > "$DIR/small.gsm"
+program 1000 20 > "$DIR/medium.gsm"
+program 2 1000000 > "$DIR/long.gsm"
+
+# Prints the best wall time of the command in milliseconds.
+best() {
+  local Best= Start End T
+  for ((I = 0; I < RUNS; I++)); do
+    Start=$(date +%s%N)
+    "$@" > /dev/null || { echo "failed: $*" >&2; exit 1; }
+    End=$(date +%s%N)
+    T=$(( (End - Start) / 1000000 ))
+    if [ -z "$Best" ] || [ "$T" -lt "$Best" ]; then Best=$T; fi
+  done
+  echo "$Best"
+}
+
+printf "%-8s %8s %14s %10s %12s\n" program lines "default [ms]" "-O2 [ms]" "fast [ms]"
+for P in small medium long; do
+  F="$DIR/$P.gsm"
+  DEFAULT=$(best "$GSM" -files "$F" --run -precompute=false)
+  O2=$(best "$GSM" -files "$F" --run -precompute=false -O2)
+  FAST=$(best "$GSM" -files "$F" --run -precompute=false --fast-compile)
+  printf "%-8s %8d %14d %10d %12d\n" "$P" "$(wc -l < "$F")" "$DEFAULT" "$O2" "$FAST"
+done
@@ -1,370 +1,463 @@
-#ifndef AST_H
-#define AST_H
-
-#include "llvm/ADT/SmallVector.h"
-#include "llvm/ADT/StringRef.h"
-#include "llvm/Support/Casting.h"
-using namespace llvm;
-// Forward declarations of classes used in the AST
-class AST;
-class Expr;
-class GSM;
-class Factor;
-class BinaryOp_Calculators;
-class BinaryOp_Relational;
-class BinaryOp_Logical;
-class BinaryOp_Attribution;
-class Assignment;
-class Declaration;
-class Loop;
-class Condition;
-
-// ASTVisitor class defines a visitor pattern to traverse the AST
-class ASTVisitor
-{
-public:
-  // Virtual visit functions for each AST node type
-  virtual void visit(AST &) {}               // Visit the base AST node
-  virtual void visit(Expr &) {}              // Visit the expression node
-  virtual void visit(GSM &) = 0;             // Visit the group of expressions node
-  virtual void visit(Factor &) = 0;                      // Visit the factor node
-  virtual void visit(BinaryOp_Calculators &) = 0;        // Visit the binary operation node
-  virtual void visit(BinaryOp_Relational &) = 0;
-  virtual void visit(BinaryOp_Logical &) = 0;
-  virtual void visit(BinaryOp_Attribution &) = 0;
-  virtual void visit(Assignment &) = 0;      // Visit the assignment expression node
-  virtual void visit(Declaration &) = 0;     // Visit the variable declaration node
-};
-
-// AST class serves as the base class for all AST nodes
-class AST
-{
-public:
-  virtual ~AST() {}
-  virtual void accept(ASTVisitor &V) = 0;    // Accept a visitor for traversal
-};
-
-// Expr class represents an expression in the AST
-class Expr : public AST
-{
-public:
-  Expr() {}
-};
-
-// Goal class represents a group of expressions in the AST
-class GSM : public Expr
-{
-  using ExprVector = llvm::SmallVector<Expr *>;
-
-private:
-  ExprVector exprs;                          // Stores the list of expressions
-
-public:
-  GSM(llvm::SmallVector<Expr *> exprs) : exprs(exprs) {}
-
-  llvm::SmallVector<Expr *> getExprs() { return exprs; }
-
-  ExprVector::const_iterator begin() { return exprs.begin(); }
-
-  ExprVector::const_iterator end() { return exprs.end(); }
-
-  virtual void accept(ASTVisitor &V) override
-  {
-    V.visit(*this);
-  }
-};
-
-// Factor class represents a factor in the AST (either an identifier or a number)
-class Factor : public Expr
-{
-public:
-  enum ValueKind
-  {
-    Ident,
-    Number
-  };
-
-private:
-  ValueKind Kind;                            // Stores the kind of factor (identifier or number)
-  llvm::StringRef Val;                       // Stores the value of the factor
-
-public:
-  Factor(ValueKind Kind, llvm::StringRef Val) : Kind(Kind), Val(Val) {}
-
-  ValueKind getKind() { return Kind; }
-
-  llvm::StringRef getVal() { return Val; }
-
-  virtual void accept(ASTVisitor &V) override
-  {
-    V.visit(*this);
-  }
-};
-
-class BinaryOp_Relational : public Expr
-{
-public:
-  enum Operator
-  {
-    Equality,
-    Not_equal,
-    Greater_than_or_equal,
-    Less_than_or_equal,
-    Greater_than,
-    Less_than
-  };
-
-private:
-  Expr *Left;                               // Left-hand side expression
-  Expr *Right;                              // Right-hand side expression
-  Operator Op;                              // Operator of the binary operation
-
-public:
-  BinaryOp_Relational(Operator Op, Expr *L, Expr *R) : Op(Op), Left(L), Right(R) {}
-
-  Expr *getLeft() { return Left; }
-
-  Expr *getRight() { return Right; }
-
-  Operator getOperator() { return Op; }
-
-  virtual void accept(ASTVisitor &V) override
-  {
-    V.visit(*this);
-  }
-};
-
-// BinaryOp class represents a binary operation in the AST (plus, minus, multiplication, division)
-class BinaryOp_Calculators : public Expr
-{
-public:
-  enum Operator
-  {
-    Plus,
-    Minus,
-    Mul,
-    Div,
-    Percent,
-    Power
-  };
-
-private:
-  Expr *Left;                               // Left-hand side expression
-  Expr *Right;                              // Right-hand side expression
-  Operator Op;                              // Operator of the binary operation
-
-public:
-  BinaryOp_Calculators(Operator Op, Expr *L, Expr *R) : Op(Op), Left(L), Right(R) {}
-
-  Expr *getLeft() { return Left; }
-
-  Expr *getRight() { return Right; }
-
-  Operator getOperator() { return Op; }
-
-  virtual void accept(ASTVisitor &V) override
-  {
-    V.visit(*this);
-  }
-};
-
-class BinaryOp_Attribution : public Expr
-{
-public:
-  enum Operator
-  {
-    Plus_equal,
-    Minus_equal,
-    Slash_equal,
-    Star_equal
-  };
-
-private:
-  Expr *Left;                               // Left-hand side expression
-  Expr *Right;                              // Right-hand side expression
-  Operator Op;                              // Operator of the binary operation
-
-public:
-  BinaryOp_Attribution(Operator Op, Expr *L, Expr *R) : Op(Op), Left(L), Right(R) {}
-
-  Expr *getLeft() { return Left; }
-
-  Expr *getRight() { return Right; }
-
-  // llvm::StringRef getLeftvalue() { return Left->getText(); } // mahsein added
-
-  Operator getOperator() { return Op; }
-
-  virtual void accept(ASTVisitor &V) override
-  {
-    V.visit(*this);
-  }
-};
-
-class BinaryOp_Logical : public Expr
-{
-public:
-  enum Operator
-  {
-    KW_OR,
-    KW_AND
-  };
-
-private:
-  Expr *Left;                               // Left-hand side expression
-  Expr *Right;                              // Right-hand side expression
-  Operator Op;                              // Operator of the binary operation
-
-public:
-  BinaryOp_Logical(Operator Op, Expr *L, Expr *R) : Op(Op), Left(L), Right(R) {}
-
-  Expr *getLeft() { return Left; }
-
-  Expr *getRight() { return Right; }
-
-  Operator getOperator() { return Op; }
-
-  virtual void accept(ASTVisitor &V) override
-  {
-    V.visit(*this);
-  }
-};
-
-class Condition : public Expr {
-  using ExprVector = llvm::SmallVector<Expr *>;
-
-private:
-  ExprVector exprs;
-
-public:
-  Condition(llvm::SmallVector<Expr *> exprs) : exprs(exprs) {}
-
-  llvm::SmallVector<Expr *> getExprs() { return exprs; }
-
-  ExprVector::const_iterator begin() { return exprs.begin(); }
-
-  ExprVector::const_iterator end() { return exprs.end(); }
-
-  // enum Sign {
-  //   None,
-  //   Equals,
-  //   NotEquals,
-  //   GreaterThanOrEqual,
-  //   LessThanOrEqual,
-  //   GreaterThan,
-  //   LessThan
-  // };
-
-  // Sign getSign() {
-  //   // For this example, assuming a simple condition represented by BinaryOp_Relational
-  //   // with one relational operator
-  //   if (exprs.size() == 1) {
-  //     BinaryOp_Relational *relation = BinaryOp_Relational(exprs[1],exprs[0],exprs[2])*;
-  //     switch (relation->getOperator()) {
-  //       case BinaryOp_Relational::Equality:
-  //         return Equals;
-  //       case BinaryOp_Relational::Not_equal:
-  //         return NotEquals;
-  //       case BinaryOp_Relational::Greater_than_or_equal:
-  //         return GreaterThanOrEqual;
-  //       case BinaryOp_Relational::Less_than_or_equal:
-  //         return LessThanOrEqual;
-  //       case BinaryOp_Relational::Greater_than:
-  //         return GreaterThan;
-  //       case BinaryOp_Relational::Less_than:
-  //         return LessThan;
-  //       default:
-  //         return None;
-  //     }
-  //   }
-  //   return None;
-  // }
-
-  // Expr *getLeft() {
-  //   if (exprs.size() == 1) {
-  //     BinaryOp_Relational *relation = (BinaryOp_Relational)(exprs[0]);
-  //     return relation->getLeft();
-  //   }
-  //   return nullptr;
-  // }
-
-  // Expr *getRight() {
-  //   if (exprs.size() == 1) {
-  //     BinaryOp_Relational *relation = (BinaryOp_Relational)(exprs[0]);
-  //     return relation->getRight();
-  //   }
-  //   return nullptr;
-  // }
-
-  virtual void accept(ASTVisitor &V) override {
-    V.visit(*this);
-  }
-};
-
-class Loop : public Expr
-{
-
-using ExprVector = llvm::SmallVector<Expr *>;  
-
-private:
-  ExprVector exprs; 
-
-public : 
-  Loop(llvm::SmallVector<Expr *> exprs) : exprs(exprs) {}
-
-  llvm::SmallVector<Expr *> getExprs() { return exprs; }
-
-  ExprVector::const_iterator begin() { return exprs.begin(); }
-
-  ExprVector::const_iterator end() { return exprs.end(); }
-
-  virtual void accept(ASTVisitor &V) override
-  {
-    V.visit(*this);
-  }
-};
-
-
-// Assignment class represents an assignment expression in the AST
-class Assignment : public Expr
-{
-private:
-  Factor *Left;                             // Left-hand side factor (identifier)
-  Expr *Right;                              // Right-hand side expression
-
-public:
-  Assignment(Factor *L, Expr *R) : Left(L), Right(R) {}
-
-  Factor *getLeft() { return Left; }
-
-  Expr *getRight() { return Right; }
-
-  virtual void accept(ASTVisitor &V) override
-  {
-    V.visit(*this);
-  }
-};
-
-// Declaration class represents a variable declaration with an initializer in the AST
-class Declaration : public Expr
-{
-  using VarVector = llvm::SmallVector<llvm::StringRef, 8>;
-  VarVector Vars;                           // Stores the list of variables
-  Expr *E;                                  // Expression serving as the initializer
-
-public:
-  Declaration(llvm::SmallVector<llvm::StringRef, 8> Vars, Expr *E) : Vars(Vars), E(E) {}
-
-  VarVector::const_iterator begin() { return Vars.begin(); }
-
-  VarVector::const_iterator end() { return Vars.end(); }
-
-  Expr *getExpr() { return E; }
-
-  virtual void accept(ASTVisitor &V) override
-  {
-    V.visit(*this);
-  }
-};
-
-#endif
+#ifndef AST_H
+#define AST_H
+
+#include "Lexer.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Casting.h"
+using namespace llvm;
+// Forward declarations of classes used in the AST
+class AST;
+class Expr;
+class GSM;
+class Factor;
+class BinaryOp_Calculators;
+class BinaryOp_Relational;
+class BinaryOp_Logical;
+class BinaryOp_Attribution;
+class Assignment;
+class Declaration;
+class Loop;
+class Condition;
+
+// ASTVisitor class defines a visitor pattern to traverse the AST
+class ASTVisitor
+{
+public:
+  // Virtual visit functions for each AST node type
+  virtual void visit(AST &) {}               // Visit the base AST node
+  virtual void visit(Expr &) {}              // Visit the expression node
+  virtual void visit(GSM &) = 0;             // Visit the group of expressions node
+  virtual void visit(Factor &) = 0;                      // Visit the factor node
+  virtual void visit(BinaryOp_Calculators &) = 0;        // Visit the binary operation node
+  virtual void visit(BinaryOp_Relational &) = 0;
+  virtual void visit(BinaryOp_Logical &) = 0;
+  virtual void visit(BinaryOp_Attribution &) = 0;
+  virtual void visit(Assignment &) = 0;      // Visit the assignment expression node
+  virtual void visit(Declaration &) = 0;     // Visit the variable declaration node
+  virtual void visit(Condition &) {}         // Visit the if/elif/else node
+  virtual void visit(Loop &) {}              // Visit the loopc node
+};
+
+// AST class serves as the base class for all AST nodes. Every node owns its
+// children and deletes them with itself.
+class AST
+{
+public:
+  virtual ~AST() {}
+  virtual void accept(ASTVisitor &V) = 0;    // Accept a visitor for traversal
+};
+
+// Expr class represents an expression in the AST
+class Expr : public AST
+{
+public:
+  // Discriminator for LLVM-style isa<>/dyn_cast<> on expressions
+  enum ExprKind
+  {
+    EK_GSM,
+    EK_Factor,
+    EK_BinaryOp_Calculators,
+    EK_BinaryOp_Relational,
+    EK_BinaryOp_Logical,
+    EK_BinaryOp_Attribution,
+    EK_Condition,
+    EK_Loop,
+    EK_Assignment,
+    EK_Declaration
+  };
+
+private:
+  const ExprKind Kind;
+  SourceLoc Loc;                             // Where the expression starts, set by the parser
+
+public:
+  Expr(ExprKind Kind) : Kind(Kind) {}
+
+  ExprKind getExprKind() const { return Kind; }
+
+  SourceLoc getLoc() const { return Loc; }
+  void setLoc(SourceLoc L) { Loc = L; }
+};
+
+// Goal class represents a group of expressions in the AST
+class GSM : public Expr
+{
+  using ExprVector = llvm::SmallVector<Expr *>;
+
+private:
+  ExprVector exprs;                          // Stores the list of expressions
+
+public:
+  GSM(llvm::SmallVector<Expr *> exprs) : Expr(EK_GSM), exprs(exprs) {}
+
+  ~GSM() override
+  {
+    for (Expr *E : exprs)
+      delete E;
+  }
+
+  llvm::SmallVector<Expr *> getExprs() { return exprs; }
+
+  ExprVector::const_iterator begin() { return exprs.begin(); }
+
+  ExprVector::const_iterator end() { return exprs.end(); }
+
+  virtual void accept(ASTVisitor &V) override
+  {
+    V.visit(*this);
+  }
+
+  static bool classof(const Expr *E)
+  {
+    return E->getExprKind() == EK_GSM;
+  }
+};
+
+// Factor class represents a factor in the AST (either an identifier or a number)
+class Factor : public Expr
+{
+public:
+  enum ValueKind
+  {
+    Ident,
+    Number
+  };
+
+private:
+  ValueKind Kind;                            // Stores the kind of factor (identifier or number)
+  llvm::StringRef Val;                       // Stores the value of the factor
+
+public:
+  Factor(ValueKind Kind, llvm::StringRef Val) : Expr(EK_Factor), Kind(Kind), Val(Val) {}
+
+  ValueKind getKind() { return Kind; }
+
+  llvm::StringRef getVal() { return Val; }
+
+  virtual void accept(ASTVisitor &V) override
+  {
+    V.visit(*this);
+  }
+
+  static bool classof(const Expr *E)
+  {
+    return E->getExprKind() == EK_Factor;
+  }
+};
+
+class BinaryOp_Relational : public Expr
+{
+public:
+  enum Operator
+  {
+    Equality,
+    Not_equal,
+    Greater_than_or_equal,
+    Less_than_or_equal,
+    Greater_than,
+    Less_than
+  };
+
+private:
+  Expr *Left;                               // Left-hand side expression
+  Expr *Right;                              // Right-hand side expression
+  Operator Op;                              // Operator of the binary operation
+
+public:
+  BinaryOp_Relational(Operator Op, Expr *L, Expr *R) : Expr(EK_BinaryOp_Relational), Op(Op), Left(L), Right(R) {}
+
+  ~BinaryOp_Relational() override
+  {
+    delete Left;
+    delete Right;
+  }
+
+  Expr *getLeft() { return Left; }
+
+  Expr *getRight() { return Right; }
+
+  Operator getOperator() { return Op; }
+
+  virtual void accept(ASTVisitor &V) override
+  {
+    V.visit(*this);
+  }
+
+  static bool classof(const Expr *E)
+  {
+    return E->getExprKind() == EK_BinaryOp_Relational;
+  }
+};
+
+// BinaryOp class represents a binary operation in the AST (plus, minus, multiplication, division)
+class BinaryOp_Calculators : public Expr
+{
+public:
+  enum Operator
+  {
+    Plus,
+    Minus,
+    Mul,
+    Div,
+    Percent,
+    Power
+  };
+
+private:
+  Expr *Left;                               // Left-hand side expression
+  Expr *Right;                              // Right-hand side expression
+  Operator Op;                              // Operator of the binary operation
+
+public:
+  BinaryOp_Calculators(Operator Op, Expr *L, Expr *R) : Expr(EK_BinaryOp_Calculators), Op(Op), Left(L), Right(R) {}
+
+  ~BinaryOp_Calculators() override
+  {
+    delete Left;
+    delete Right;
+  }
+
+  Expr *getLeft() { return Left; }
+
+  Expr *getRight() { return Right; }
+
+  Operator getOperator() { return Op; }
+
+  virtual void accept(ASTVisitor &V) override
+  {
+    V.visit(*this);
+  }
+
+  static bool classof(const Expr *E)
+  {
+    return E->getExprKind() == EK_BinaryOp_Calculators;
+  }
+};
+
+class BinaryOp_Attribution : public Expr
+{
+public:
+  enum Operator
+  {
+    Plus_equal,
+    Minus_equal,
+    Slash_equal,
+    Star_equal
+  };
+
+private:
+  Expr *Left;                               // Left-hand side expression
+  Expr *Right;                              // Right-hand side expression
+  Operator Op;                              // Operator of the binary operation
+
+public:
+  BinaryOp_Attribution(Operator Op, Expr *L, Expr *R) : Expr(EK_BinaryOp_Attribution), Op(Op), Left(L), Right(R) {}
+
+  ~BinaryOp_Attribution() override
+  {
+    delete Left;
+    delete Right;
+  }
+
+  Expr *getLeft() { return Left; }
+
+  Expr *getRight() { return Right; }
+
+  // llvm::StringRef getLeftvalue() { return Left->getText(); } // mahsein added
+
+  Operator getOperator() { return Op; }
+
+  virtual void accept(ASTVisitor &V) override
+  {
+    V.visit(*this);
+  }
+
+  static bool classof(const Expr *E)
+  {
+    return E->getExprKind() == EK_BinaryOp_Attribution;
+  }
+};
+
+class BinaryOp_Logical : public Expr
+{
+public:
+  enum Operator
+  {
+    KW_OR,
+    KW_AND
+  };
+
+private:
+  Expr *Left;                               // Left-hand side expression
+  Expr *Right;                              // Right-hand side expression
+  Operator Op;                              // Operator of the binary operation
+
+public:
+  BinaryOp_Logical(Operator Op, Expr *L, Expr *R) : Expr(EK_BinaryOp_Logical), Op(Op), Left(L), Right(R) {}
+
+  ~BinaryOp_Logical() override
+  {
+    delete Left;
+    delete Right;
+  }
+
+  Expr *getLeft() { return Left; }
+
+  Expr *getRight() { return Right; }
+
+  Operator getOperator() { return Op; }
+
+  virtual void accept(ASTVisitor &V) override
+  {
+    V.visit(*this);
+  }
+
+  static bool classof(const Expr *E)
+  {
+    return E->getExprKind() == EK_BinaryOp_Logical;
+  }
+};
+
+class Condition : public Expr {
+public:
+  // One if/elif arm, or the else arm when Cond is null
+  struct Arm
+  {
+    Expr *Cond;
+    llvm::SmallVector<Expr *> Body;
+  };
+  using ArmVector = llvm::SmallVector<Arm, 2>;
+
+private:
+  ArmVector Arms;                           // Arms in source order
+
+public:
+  Condition(ArmVector Arms) : Expr(EK_Condition), Arms(Arms) {}
+
+  ~Condition() override
+  {
+    for (Arm &A : Arms)
+    {
+      delete A.Cond;
+      for (Expr *E : A.Body)
+        delete E;
+    }
+  }
+
+  ArmVector &getArms() { return Arms; }
+
+  ArmVector::iterator begin() { return Arms.begin(); }
+
+  ArmVector::iterator end() { return Arms.end(); }
+
+  virtual void accept(ASTVisitor &V) override {
+    V.visit(*this);
+  }
+
+  static bool classof(const Expr *E)
+  {
+    return E->getExprKind() == EK_Condition;
+  }
+};
+
+class Loop : public Expr
+{
+
+using ExprVector = llvm::SmallVector<Expr *>;  
+
+private:
+  Expr *Cond;                               // Loop condition, checked before each iteration
+  ExprVector exprs; 
+
+public : 
+  Loop(Expr *Cond, llvm::SmallVector<Expr *> exprs) : Expr(EK_Loop), Cond(Cond), exprs(exprs) {}
+
+  ~Loop() override
+  {
+    delete Cond;
+    for (Expr *E : exprs)
+      delete E;
+  }
+
+  Expr *getCond() { return Cond; }
+
+  llvm::SmallVector<Expr *> getExprs() { return exprs; }
+
+  ExprVector::const_iterator begin() { return exprs.begin(); }
+
+  ExprVector::const_iterator end() { return exprs.end(); }
+
+  virtual void accept(ASTVisitor &V) override
+  {
+    V.visit(*this);
+  }
+
+  static bool classof(const Expr *E)
+  {
+    return E->getExprKind() == EK_Loop;
+  }
+};
+
+
+// Assignment class represents an assignment expression in the AST
+class Assignment : public Expr
+{
+private:
+  Factor *Left;                             // Left-hand side factor (identifier)
+  Expr *Right;                              // Right-hand side expression
+
+public:
+  Assignment(Factor *L, Expr *R) : Expr(EK_Assignment), Left(L), Right(R) {}
+
+  ~Assignment() override
+  {
+    delete Left;
+    delete Right;
+  }
+
+  Factor *getLeft() { return Left; }
+
+  Expr *getRight() { return Right; }
+
+  virtual void accept(ASTVisitor &V) override
+  {
+    V.visit(*this);
+  }
+
+  static bool classof(const Expr *E)
+  {
+    return E->getExprKind() == EK_Assignment;
+  }
+};
+
+// Declaration class represents a variable declaration with an initializer in the AST
+class Declaration : public Expr
+{
+  using VarVector = llvm::SmallVector<llvm::StringRef, 8>;
+  VarVector Vars;                           // Stores the list of variables
+  Expr *E;                                  // Expression serving as the initializer
+
+public:
+  Declaration(llvm::SmallVector<llvm::StringRef, 8> Vars, Expr *E) : Expr(EK_Declaration), Vars(Vars), E(E) {}
+
+  ~Declaration() override { delete E; }
+
+  VarVector::const_iterator begin() { return Vars.begin(); }
+
+  VarVector::const_iterator end() { return Vars.end(); }
+
+  Expr *getExpr() { return E; }
+
+  virtual void accept(ASTVisitor &V) override
+  {
+    V.visit(*this);
+  }
+
+  static bool classof(const Expr *E)
+  {
+    return E->getExprKind() == EK_Declaration;
+  }
+};
+
+#endif
@@ -0,0 +1,245 @@
+#include "Analysis.h"
+#include "llvm/Support/xxhash.h"
+
+namespace
+{
+  // Hand a node to every analysis before its children are visited.
+  template <typename NodeT>
+  void enterAll(llvm::SmallVectorImpl<Analysis *> &Analyses, NodeT &Node)
+  {
+    for (Analysis *A : Analyses)
+      A->visit(Node);
+  }
+
+  // Hand a node to every analysis after its children were visited.
+  template <typename NodeT>
+  void leaveAll(llvm::SmallVectorImpl<Analysis *> &Analyses, NodeT &Node)
+  {
+    for (Analysis *A : Analyses)
+      A->leave(Node);
+  }
+}
+
+bool FusedTraversal::run(AST *Tree)
+{
+  if (!Tree)
+    return false;
+
+  Tree->accept(*this);
+
+  bool HasError = false;
+  for (Analysis *A : Analyses)
+    HasError |= A->hasError();
+  return HasError;
+}
+
+void FusedTraversal::visit(GSM &Node)
+{
+  enterAll(Analyses, Node);
+  for (auto I = Node.begin(), E = Node.end(); I != E; ++I)
+  {
+    if (*I)
+      (*I)->accept(*this);
+  }
+  leaveAll(Analyses, Node);
+}
+
+void FusedTraversal::visit(Factor &Node)
+{
+  enterAll(Analyses, Node);
+}
+
+void FusedTraversal::visit(BinaryOp_Calculators &Node)
+{
+  enterAll(Analyses, Node);
+  if (Node.getLeft())
+    Node.getLeft()->accept(*this);
+  if (Node.getRight())
+    Node.getRight()->accept(*this);
+  leaveAll(Analyses, Node);
+}
+
+void FusedTraversal::visit(BinaryOp_Relational &Node)
+{
+  enterAll(Analyses, Node);
+  if (Node.getLeft())
+    Node.getLeft()->accept(*this);
+  if (Node.getRight())
+    Node.getRight()->accept(*this);
+  leaveAll(Analyses, Node);
+}
+
+void FusedTraversal::visit(BinaryOp_Logical &Node)
+{
+  enterAll(Analyses, Node);
+  if (Node.getLeft())
+    Node.getLeft()->accept(*this);
+  if (Node.getRight())
+    Node.getRight()->accept(*this);
+  leaveAll(Analyses, Node);
+}
+
+void FusedTraversal::visit(BinaryOp_Attribution &Node)
+{
+  enterAll(Analyses, Node);
+  if (Node.getLeft())
+    Node.getLeft()->accept(*this);
+  if (Node.getRight())
+    Node.getRight()->accept(*this);
+  leaveAll(Analyses, Node);
+}
+
+void FusedTraversal::visit(Assignment &Node)
+{
+  enterAll(Analyses, Node);
+  if (Node.getLeft())
+    Node.getLeft()->accept(*this);
+  if (Node.getRight())
+    Node.getRight()->accept(*this);
+  leaveAll(Analyses, Node);
+}
+
+void FusedTraversal::visit(Declaration &Node)
+{
+  enterAll(Analyses, Node);
+  if (Node.getExpr())
+    Node.getExpr()->accept(*this);
+  leaveAll(Analyses, Node);
+}
+
+void FusedTraversal::visit(Condition &Node)
+{
+  enterAll(Analyses, Node);
+  for (Condition::Arm &A : Node)
+  {
+    if (A.Cond)
+      A.Cond->accept(*this);
+    for (Expr *S : A.Body)
+    {
+      if (S)
+        S->accept(*this);
+    }
+  }
+  leaveAll(Analyses, Node);
+}
+
+void FusedTraversal::visit(Loop &Node)
+{
+  enterAll(Analyses, Node);
+  if (Node.getCond())
+    Node.getCond()->accept(*this);
+  for (auto I = Node.begin(), E = Node.end(); I != E; ++I)
+  {
+    if (*I)
+      (*I)->accept(*this);
+  }
+  leaveAll(Analyses, Node);
+}
+
+void NodeFacts::setBinary(Expr &Node, Expr *Left, Expr *Right, bool Cheap)
+{
+  Info L = get(Left), R = get(Right);
+  Nodes[&Node] = {1 + L.Size + R.Size, Cheap && L.Cheap && R.Cheap};
+}
+
+void NodeFacts::visit(Factor &Node)
+{
+  Nodes[&Node] = {1, true};
+}
+
+void NodeFacts::leave(BinaryOp_Calculators &Node)
+{
+  auto *RightF = llvm::dyn_cast_or_null<Factor>(Node.getRight());
+  bool RightIsNumber = RightF && RightF->getKind() == Factor::Number;
+  bool Cheap = true;
+  switch (Node.getOperator())
+  {
+  case BinaryOp_Calculators::Div:
+  case BinaryOp_Calculators::Percent:
+    // Only a nonzero literal divisor cannot trap.
+    Cheap = RightIsNumber && !RightF->getVal().ltrim('0').empty();
+    break;
+  case BinaryOp_Calculators::Power:
+    // A run time exponent needs the loop in gsm.pow.
+    Cheap = RightIsNumber;
+    break;
+  default:
+    break;
+  }
+  setBinary(Node, Node.getLeft(), Node.getRight(), Cheap);
+}
+
+void NodeFacts::leave(BinaryOp_Relational &Node)
+{
+  setBinary(Node, Node.getLeft(), Node.getRight(), true);
+}
+
+void NodeFacts::leave(BinaryOp_Logical &Node)
+{
+  setBinary(Node, Node.getLeft(), Node.getRight(), true);
+}
+
+// Compound assignments write variables.
+void NodeFacts::leave(BinaryOp_Attribution &Node)
+{
+  setBinary(Node, Node.getLeft(), Node.getRight(), false);
+}
+
+void NodeFacts::leave(Assignment &Node)
+{
+  Nodes[&Node] = {1 + getSize(Node.getRight()), false};
+}
+
+void NodeFacts::leave(Declaration &Node)
+{
+  Nodes[&Node] = {1 + getSize(Node.getExpr()), false};
+}
+
+void NodeFacts::leave(Condition &Node)
+{
+  unsigned N = 1;
+  for (Condition::Arm &A : Node)
+  {
+    N += getSize(A.Cond);
+    for (Expr *S : A.Body)
+      N += getSize(S);
+  }
+  Nodes[&Node] = {N, false};
+}
+
+void NodeFacts::leave(Loop &Node)
+{
+  unsigned N = 1 + getSize(Node.getCond());
+  for (auto I = Node.begin(), E = Node.end(); I != E; ++I)
+    N += getSize(*I);
+  Nodes[&Node] = {N, false};
+}
+
+bool NodeFacts::isCheapAndSafe(Expr *E, unsigned &Budget) const
+{
+  Info I = get(E);
+  if (!I.Cheap || I.Size > Budget)
+    return false;
+  Budget -= I.Size;
+  return true;
+}
+
+void ProfileCounters::visit(Condition &Node)
+{
+  unsigned N = Node.getArms().size() + (Node.getArms().back().Cond ? 1 : 0);
+  First[&Node] = NumCounters;
+  NumCounters += N;
+  Signature += "c" + std::to_string(N);
+}
+
+void ProfileCounters::visit(Loop &Node)
+{
+  First[&Node] = NumCounters;
+  NumCounters += 2;
+  Signature += "l";
+}
+
+uint64_t ProfileCounters::getHash() const
+{
+  return llvm::xxHash64(Signature);
+}
@@ -0,0 +1,135 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "AST.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include <string>
+
+// Analysis is a small set of callbacks over the AST. An analysis does not walk
+// the tree itself; it is registered with a FusedTraversal, which visits every
+// node once and hands it to all registered analyses in registration order.
+// visit() is called before the children of a node, leave() after them.
+class Analysis
+{
+public:
+  virtual ~Analysis() {}
+
+  virtual void visit(GSM &) {}
+  virtual void visit(Factor &) {}
+  virtual void visit(BinaryOp_Calculators &) {}
+  virtual void visit(BinaryOp_Relational &) {}
+  virtual void visit(BinaryOp_Logical &) {}
+  virtual void visit(BinaryOp_Attribution &) {}
+  virtual void visit(Assignment &) {}
+  virtual void visit(Declaration &) {}
+  virtual void visit(Condition &) {}
+  virtual void visit(Loop &) {}
+
+  virtual void leave(GSM &) {}
+  virtual void leave(BinaryOp_Calculators &) {}
+  virtual void leave(BinaryOp_Relational &) {}
+  virtual void leave(BinaryOp_Logical &) {}
+  virtual void leave(BinaryOp_Attribution &) {}
+  virtual void leave(Assignment &) {}
+  virtual void leave(Declaration &) {}
+  virtual void leave(Condition &) {}
+  virtual void leave(Loop &) {}
+
+  // Returns true if the analysis found an error in the tree.
+  virtual bool hasError() { return false; }
+};
+
+// FusedTraversal walks the AST exactly once and runs every registered
+// analysis on each node, so adding an analysis does not add a tree walk.
+class FusedTraversal : public ASTVisitor
+{
+  llvm::SmallVector<Analysis *, 4> Analyses;
+
+public:
+  // The traversal does not take ownership of the analysis.
+  void addAnalysis(Analysis *A) { Analyses.push_back(A); }
+
+  // Runs all registered analyses over the tree. Returns true if any of them
+  // reported an error.
+  bool run(AST *Tree);
+
+  virtual void visit(GSM &Node) override;
+  virtual void visit(Factor &Node) override;
+  virtual void visit(BinaryOp_Calculators &Node) override;
+  virtual void visit(BinaryOp_Relational &Node) override;
+  virtual void visit(BinaryOp_Logical &Node) override;
+  virtual void visit(BinaryOp_Attribution &Node) override;
+  virtual void visit(Assignment &Node) override;
+  virtual void visit(Declaration &Node) override;
+  virtual void visit(Condition &Node) override;
+  virtual void visit(Loop &Node) override;
+};
+
+// NodeFacts records, for every expression node, the number of nodes in its
+// tree and whether evaluating it is cheap, cannot trap and has no side
+// effects, so that it may be evaluated even when its value is not needed.
+// Assignment targets are not counted.
+class NodeFacts : public Analysis
+{
+  struct Info
+  {
+    unsigned Size = 0;
+    bool Cheap = false;
+  };
+  llvm::DenseMap<Expr *, Info> Nodes;
+
+  Info get(Expr *E) const { return E ? Nodes.lookup(E) : Info(); }
+  void setBinary(Expr &Node, Expr *Left, Expr *Right, bool Cheap);
+
+public:
+  virtual void visit(Factor &Node) override;
+  virtual void leave(BinaryOp_Calculators &Node) override;
+  virtual void leave(BinaryOp_Relational &Node) override;
+  virtual void leave(BinaryOp_Logical &Node) override;
+  virtual void leave(BinaryOp_Attribution &Node) override;
+  virtual void leave(Assignment &Node) override;
+  virtual void leave(Declaration &Node) override;
+  virtual void leave(Condition &Node) override;
+  virtual void leave(Loop &Node) override;
+
+  // Returns the number of expression nodes in the tree below E.
+  unsigned getSize(Expr *E) const { return get(E).Size; }
+
+  // Returns true if E is cheap and safe and has at most Budget nodes, which
+  // are then taken from the budget.
+  bool isCheapAndSafe(Expr *E, unsigned &Budget) const;
+  bool isCheapAndSafe(Expr *E) const
+  {
+    unsigned Budget = 8;
+    return isCheapAndSafe(E, Budget);
+  }
+};
+
+// ProfileCounters numbers the profile counters of the program in AST order.
+// An if with K arms has one counter per arm, plus one for taking none of
+// them if there is no else. A loop has one counter for entering the loop
+// and one for running its body. The signature of the counters identifies
+// the program a profile belongs to.
+class ProfileCounters : public Analysis
+{
+public:
+  llvm::DenseMap<Expr *, unsigned> First; // first counter of each node
+  unsigned NumCounters = 0;
+  std::string Signature;
+
+  virtual void visit(Condition &Node) override;
+  virtual void visit(Loop &Node) override;
+
+  uint64_t getHash() const;
+};
+
+// The results of the analyses that run in the traversal of the semantic
+// checks and that code generation uses.
+struct TreeFacts
+{
+  NodeFacts Nodes;
+  ProfileCounters Shape;
+};
+
+#endif
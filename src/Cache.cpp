@@ -0,0 +1,105 @@
+#include "Cache.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+namespace
+{
+  // Identify the compiler build by the size and time stamp of the running
+  // executable, so that a rebuilt gsm does not reuse stale entries.
+  std::string getCompilerId()
+  {
+    std::string Exe = sys::fs::getMainExecutable(nullptr, (void *)&getCompilerId);
+    sys::fs::file_status Status;
+    if (sys::fs::status(Exe, Status))
+      return Exe;
+    return Exe + ":" + std::to_string(Status.getSize()) + ":" +
+           std::to_string(sys::toTimeT(Status.getLastModificationTime()));
+  }
+
+  // Hash a string together with its length, so that concatenations of
+  // different strings cannot collide.
+  void update(SHA1 &Hasher, StringRef Data)
+  {
+    Hasher.update(std::to_string(Data.size()) + ":");
+    Hasher.update(Data);
+  }
+}
+
+std::string Cache::computeKey(ArrayRef<std::string> Inputs, ArrayRef<StringRef> Flags)
+{
+  SHA1 Hasher;
+  update(Hasher, getCompilerId());
+  for (StringRef Flag : Flags)
+    update(Hasher, Flag);
+  for (const std::string &Input : Inputs)
+    update(Hasher, Input);
+  return toHex(Hasher.final(), /*LowerCase=*/true);
+}
+
+std::string Cache::getEntryPath(StringRef Key)
+{
+  // pruneCache() only considers files with the llvmcache- prefix.
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, "llvmcache-" + Key);
+  return std::string(Path.str());
+}
+
+std::unique_ptr<MemoryBuffer> Cache::lookup(StringRef Key)
+{
+  std::string Path = getEntryPath(Key);
+  Expected<sys::fs::file_t> FD = sys::fs::openNativeFileForRead(Path);
+  if (!FD)
+  {
+    consumeError(FD.takeError());
+    return nullptr;
+  }
+
+  // Map the entry and mark it as recently used for eviction.
+  auto Buffer = MemoryBuffer::getOpenFile(*FD, Path, /*FileSize=*/-1,
+                                          /*RequiresNullTerminator=*/false);
+  sys::fs::setLastAccessAndModificationTime(*FD, std::chrono::system_clock::now());
+  sys::fs::closeFile(*FD);
+  if (!Buffer)
+    return nullptr;
+  return std::move(*Buffer);
+}
+
+void Cache::store(StringRef Key, StringRef Data)
+{
+  if (sys::fs::create_directories(Dir))
+    return;
+
+  // Write a temporary file and rename it into place, so that concurrent
+  // readers see either no entry or the complete one.
+  SmallString<128> Model(Dir);
+  sys::path::append(Model, "tmp-%%%%%%%%");
+  int FD;
+  SmallString<128> TempPath;
+  if (sys::fs::createUniqueFile(Model, FD, TempPath))
+    return;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Data;
+    OS.close();
+    if (OS.has_error())
+    {
+      OS.clear_error();
+      sys::fs::remove(TempPath);
+      return;
+    }
+  }
+  if (sys::fs::rename(TempPath, getEntryPath(Key)))
+  {
+    sys::fs::remove(TempPath);
+    return;
+  }
+
+  pruneCache(Dir, Policy);
+}
@@ -0,0 +1,38 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+#include <string>
+
+// Cache is a content-addressed store of compiler outputs in a directory.
+// Entries are keyed by a hash of the inputs, the flags and the compiler
+// build, written atomically so that concurrent processes can share the
+// directory, and evicted least recently used first by LLVM's cache pruning.
+class Cache
+{
+  std::string Dir;
+  llvm::CachePruningPolicy Policy;
+
+  std::string getEntryPath(llvm::StringRef Key);
+
+public:
+  Cache(llvm::StringRef Dir, llvm::CachePruningPolicy Policy)
+      : Dir(Dir.str()), Policy(Policy) {}
+
+  // Computes the key for the given inputs and the flags that affect the
+  // output. The identity of the compiler executable is part of the key.
+  static std::string computeKey(llvm::ArrayRef<std::string> Inputs,
+                                llvm::ArrayRef<llvm::StringRef> Flags);
+
+  // Returns the mapped entry for the key, or nullptr if there is none.
+  std::unique_ptr<llvm::MemoryBuffer> lookup(llvm::StringRef Key);
+
+  // Stores the data under the key and prunes the cache if it is due.
+  void store(llvm::StringRef Key, llvm::StringRef Data);
+};
+
+#endif
@@ -1,377 +1,1373 @@
-#include "CodeGen.h"
-#include "llvm/ADT/StringMap.h"
-#include "llvm/IR/IRBuilder.h"
-#include "llvm/IR/LLVMContext.h"
-#include "llvm/Support/raw_ostream.h"
-
-using namespace llvm;
-
-// Define a visitor class for generating LLVM IR from the AST.
-namespace
-{
-  class ToIRVisitor : public ASTVisitor
-  {
-    Module *M;
-    IRBuilder<> Builder;
-    Type *VoidTy;
-    Type *Int32Ty;
-    Type *Int8PtrTy;
-    Type *Int8PtrPtrTy;
-    Constant *Int32Zero;
-
-    Value *V;
-    StringMap<AllocaInst *> nameMap;
-
-  public:
-    // Constructor for the visitor class.
-    ToIRVisitor(Module *M) : M(M), Builder(M->getContext())
-    {
-      // Initialize LLVM types and constants.
-      VoidTy = Type::getVoidTy(M->getContext());
-      Int32Ty = Type::getInt32Ty(M->getContext());
-      Int8PtrTy = Type::getInt8PtrTy(M->getContext());
-      Int8PtrPtrTy = Int8PtrTy->getPointerTo();
-      Int32Zero = ConstantInt::get(Int32Ty, 0, true);
-    }
-
-    // Entry point for generating LLVM IR from the AST.
-    void run(AST *Tree)
-    {
-      // Create the main function with the appropriate function type.
-      FunctionType *MainFty = FunctionType::get(Int32Ty, {Int32Ty, Int8PtrPtrTy}, false);
-      Function *MainFn = Function::Create(MainFty, GlobalValue::ExternalLinkage, "main", M);
-
-      // Create a basic block for the entry point of the main function.
-      BasicBlock *BB = BasicBlock::Create(M->getContext(), "entry", MainFn);
-      Builder.SetInsertPoint(BB);
-
-      // Visit the root node of the AST to generate IR.
-      Tree->accept(*this);
-
-      // Create a return instruction at the end of the main function.
-      Builder.CreateRet(Int32Zero);
-    }
-
-    // Visit function for the Goal node in the AST.
-    virtual void visit(GSM &Node) override
-    {
-      // Iterate over the children of the Goal node and visit each child.
-      for (auto I = Node.begin(), E = Node.end(); I != E; ++I)
-      {
-        (*I)->accept(*this);
-      }
-    };
-
-    virtual void visit(Assignment &Node) override
-    {
-      // Visit the right-hand side of the assignment and get its value.
-      Node.getRight()->accept(*this);
-      Value *val = V;
-
-      // Get the name of the variable being assigned.
-      auto varName = Node.getLeft()->getVal();
-
-      // Create a store instruction to assign the value to the variable.
-      Builder.CreateStore(val, nameMap[varName]);
-
-      // Create a function type for the "gsm_write" function.
-      FunctionType *CalcWriteFnTy = FunctionType::get(VoidTy, {Int32Ty}, false);
-
-      // Create a function declaration for the "gsm_write" function.
-      Function *CalcWriteFn = Function::Create(CalcWriteFnTy, GlobalValue::ExternalLinkage, "gsm_write", M);
-
-      // Create a call instruction to invoke the "gsm_write" function with the value.
-      CallInst *Call = Builder.CreateCall(CalcWriteFnTy, CalcWriteFn, {val});
-    };
-
-    virtual void visit(Factor &Node) override
-    {
-      if (Node.getKind() == Factor::Ident)
-      {
-        // If the factor is an identifier, load its value from memory.
-        V = Builder.CreateLoad(Int32Ty, nameMap[Node.getVal()]);
-      }
-      else
-      {
-        // If the factor is a literal, convert it to an integer and create a constant.
-        int intval;
-        Node.getVal().getAsInteger(10, intval);
-        V = ConstantInt::get(Int32Ty, intval, true);
-      }
-    };
-
-    virtual void visit(BinaryOp_Calculators &Node) override
-    {
-      // Visit the left-hand side of the binary operation and get its value.
-      Node.getLeft()->accept(*this);
-      Value *Left = V;
-
-      // Visit the right-hand side of the binary operation and get its value.
-      Node.getRight()->accept(*this);
-
-      Factor *f = (Factor *)(Node.getRight());
-
-      int intval;
-      Value *Right = V;
-      int iterator = 1;
-      // Perform the binary operation based on the operator type and create the corresponding instruction.
-      switch (Node.getOperator())
-      {
-      case BinaryOp_Calculators::Plus:
-        V = Builder.CreateNSWAdd(Left, Right);
-        break;
-      case BinaryOp_Calculators::Minus:
-        V = Builder.CreateNSWSub(Left, Right);
-        break;
-      case BinaryOp_Calculators::Mul:
-        V = Builder.CreateNSWMul(Left, Right);
-        break;
-      case BinaryOp_Calculators::Div:
-        V = Builder.CreateSDiv(Left, Right);
-        break;
-      case BinaryOp_Calculators::Percent:
-        V = Builder.CreateSRem(Left, Right);
-        break;
-      case BinaryOp_Calculators::Power:
-{
-            // Check if the right side of the power operation is a number
-            if (f && f->getKind() == Factor::Number)
-            {
-                int right_integer;
-                if (f->getVal().getAsInteger(10, right_integer)) {
-                    // Handle error: unable to convert the exponent to an integer
-                    // Handle the error scenario as needed
-                } else {
-                    // Create an initial value for the result
-                    V = Left;
-
-                    // If the exponent is 0, set the result to 1
-                    if (right_integer == 0) {
-                        V = ConstantInt::get(Int32Ty, 1, true);
-                    } else {
-                        // Initialize the result to 1
-                        V = ConstantInt::get(Int32Ty, 1, true);
-                        
-                        // Multiply 'Left' by itself 'right_integer' times
-                        for (int i = 0; i < right_integer; ++i) {
-                            V = Builder.CreateNSWMul(V, Left);
-                        }
-                    }
-                }
-            }
-            break;
-        }
-      }
-
-    };
-
-    virtual void visit(BinaryOp_Logical &Node) override
-    {
-      // Visit the left-hand side of the binary operation and get its value.
-      Node.getLeft()->accept(*this);
-      Value *Left = V;
-
-      // Visit the right-hand side of the binary operation and get its value.
-      Node.getRight()->accept(*this);
-      Value *Right = V;
-
-      // Perform the binary operation based on the operator type and create the corresponding instruction.
-      switch (Node.getOperator())
-      {
-      case BinaryOp_Logical::KW_AND:
-        V = Builder.CreateAnd(Left, Right);
-        break;
-      case BinaryOp_Logical::KW_OR:
-        V = Builder.CreateOr(Left, Right);
-        break;
-      }
-    };
-
-    virtual void visit(BinaryOp_Attribution &Node) override
-    {
-      // Visit the left-hand side of the binary operation and get its value.
-      Node.getLeft()->accept(*this);
-      Value *Left = V;
-      
-      // Visit the right-hand side of the binary operation and get its value.
-      Node.getRight()->accept(*this);
-      Value *Right = V;
-
-      // Perform the binary operation based on the operator type and create the corresponding instruction.
-      switch (Node.getOperator())
-      {
-      case BinaryOp_Attribution::Plus_equal:
-        {
-           Value *Result = Builder.CreateAdd(Left, Right);
-
-            Builder.CreateStore(Result, Left);
-            V = Result; // Set the current value to the result if needed
-            break;
-        }
-      case BinaryOp_Attribution::Minus_equal:
-        {
-            Value *Result = Builder.CreateSub(Left, Right);
-
-            Builder.CreateStore(Result, Left);
-            V = Result; // Set the current value to the result if needed
-            break;
-        }
-      case BinaryOp_Attribution::Slash_equal:
-        {
-            // Perform division
-            Value *Result = Builder.CreateSDiv(Left, Right);
-            // Mahsein, [12/15/2023 12:35 AM]
-            // Assign the result back to 'Left'
-            Builder.CreateStore(Result, Left);
-            V = Result; // Set the current value to the result if needed
-            break;
-        }
-
-      case BinaryOp_Attribution::Star_equal:
-        {
-            // Perform division
-            Value *Result = Builder.CreateMul(Left, Right);
-
-            // Assign the result back to 'Left'
-            Builder.CreateNSWMul(Result, Left);
-            V = Result; // Set the current value to the result if needed
-            break;
-        }
-      }
-    };
-
-    // virtual void visit(Condition &Node) override
-    // {
-    //   llvm::SmallVector<Expr *> exprs = Node.getExprs();
-    //   auto Left1 = exprs[0];
-    //   auto condition1 = exprs[1];
-    //   auto Right1 = exprs[2];
-    //   Left1->accept(*this);
-    //   Value* Left = V;
-    //   Right1->accept(*this);
-    //   Value* Right = V;
-    //   switch (Node.getSign())
-    //   {
-    //   case Condition::Operator::Equal:
-    //     V = Builder.CreateICmpEQ(Left, Right);
-    //     break;
-    //   case Condition::Operator::Less:
-    //     V = Builder.CreateICmpSLT(Left, Right);
-    //     break;
-    //   case Condition::Operator::LessEqual:
-    //     V = Builder.CreateICmpSLE(Left, Right);
-    //     break;
-    //   case Condition::Operator::GreaterEqual:
-    //     V = Builder.CreateICmpSGE(Left, Right);
-    //     break;
-    //   case Condition::Operator::Greater:
-    //     V = Builder.CreateICmpSGT(Left, Right);
-    //     break;
-    //   case Condition::Operator::NotEqual:
-    //     V = Builder.CreateICmpNE(Left, Right);
-    //   }
-    // };
-    // virtual void visit(Loop &Node) override
-    // {
-
-    //   llvm::BasicBlock* loopifbb = llvm::BasicBlock::Create(M->getContext(), "loopc.cond", MainFn);
-    //   llvm::BasicBlock* loopbodybb = llvm::BasicBlock::Create(M->getContext(), "loopc.body", MainFn);
-    //   llvm::BasicBlock* afterloopbb = llvm::BasicBlock::Create(M->getContext(), "after.loopc", MainFn);
-
-    //   Builder.CreateBr(loopifbb);
-    //   Builder.SetInsertPoint(loopifbb);
-    //   Node.getCondition()->accept(*this);
-    //   Value* val=V;
-    //   Builder.CreateCondBr(val, loopbodybb, afterloopbb);
-    //   Builder.SetInsertPoint(loopbodybb);
-    //   llvm::SmallVector<AssignStatement* > assignStatements = Node.getAssignments();
-    //   for (auto I = assignStatements.begin(), E = assignStatements.end(); I != E; ++I)
-    //   {
-    //     (*I)->accept(*this);
-    //   }
-    //   Builder.CreateBr(loopifbb);
-
-    //   Builder.SetInsertPoint(afterloopbb);
-    // }
-    virtual void visit(BinaryOp_Relational &Node) override
-    {
-      // Visit the left-hand side of the binary operation and get its value.
-      Node.getLeft()->accept(*this);
-      Value *Left = V;
-
-      // Visit the right-hand side of the binary operation and get its value.
-      Node.getRight()->accept(*this);
-      Value *Right = V;
-
-      // Perform the binary operation based on the operator type and create the corresponding instruction.
-      switch (Node.getOperator())
-      {
-
-      case BinaryOp_Relational::Equality:
-        V = Builder.CreateICmpEQ(Left, Right);
-        break;
-
-      case BinaryOp_Relational::Not_equal:
-        V = Builder.CreateICmpNE(Left, Right);
-        break;
-
-      case BinaryOp_Relational::Greater_than_or_equal:
-        V = Builder.CreateICmpSGE(Left, Right);
-        break;
-
-      case BinaryOp_Relational::Less_than_or_equal:
-        V = Builder.CreateICmpSLE(Left, Right);
-        break;
-
-      case BinaryOp_Relational::Greater_than:
-        V = Builder.CreateICmpSGT(Left, Right);
-        break;
-
-      case BinaryOp_Relational::Less_than:
-        V = Builder.CreateICmpSLT(Left, Right);
-        break;
-      }
-    };
-
-    virtual void visit(Declaration &Node) override
-    {
-      Value *val = nullptr;
-
-      if (Node.getExpr())
-      {
-        // If there is an expression provided, visit it and get its value.
-        Node.getExpr()->accept(*this);
-        val = V;
-      }
-
-      // Iterate over the variables declared in the declaration statement.
-      for (auto I = Node.begin(), E = Node.end(); I != E; ++I)
-      {
-        StringRef Var = *I;
-
-        // Create an alloca instruction to allocate memory for the variable.
-        nameMap[Var] = Builder.CreateAlloca(Int32Ty);
-
-        // Store the initial value (if any) in the variable's memory location.
-        if (val != nullptr)
-        {
-          Builder.CreateStore(val, nameMap[Var]);
-        }
-      }
-    };
-  };
-}; // namespace
-
-void CodeGen::compile(AST *Tree)
-{
-  // Create an LLVM context and a module.
-  LLVMContext Ctx;
-  Module *M = new Module("calc.expr", Ctx);
-
-  // Create an instance of the ToIRVisitor and run it on the AST to generate LLVM IR.
-  ToIRVisitor ToIR(M);
-  ToIR.run(Tree);
-
-  // Print the generated module to the standard output.
-  M->print(outs(), nullptr);
-}
+#include "CodeGen.h"
+#include "Analysis.h"
+#include "Evaluator.h"
+#include "Profile.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/DIBuilder.h"
+#include "llvm/IR/DiagnosticHandler.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+// Options controlling when if/elif/else is lowered to select instructions.
+static cl::opt<bool>
+    SelectIfs("select-if",
+              cl::desc("Lower if/elif/else arms that only assign cheap values to selects"),
+              cl::init(true));
+
+static cl::opt<unsigned>
+    SelectIfThreshold("select-if-threshold",
+                      cl::desc("Maximum number of expression nodes evaluated by a select-lowered if"),
+                      cl::init(32));
+
+// Option controlling when if/elif chains are lowered to a switch.
+static cl::opt<unsigned>
+    SwitchMinCases("switch-min-cases",
+                   cl::desc("Minimum number of 'var == literal' arms lowered to a switch (0 disables)"),
+                   cl::init(3));
+
+// Option controlling how the program is partitioned into functions.
+static cl::opt<unsigned>
+    SplitFunctions("split-functions",
+                   cl::desc("Put top-level statements into internal functions of about "
+                            "this many expression nodes each (0 disables)"),
+                   cl::init(0));
+
+// Option for source-level debugging and profiling.
+static cl::opt<bool>
+    DebugInfo("g",
+              cl::desc("Generate DWARF debug information"),
+              cl::init(false));
+
+// Options for profile-guided optimization.
+static cl::opt<std::string>
+    ProfileGenerate("profile-generate",
+                    cl::desc("Count the arms and loop iterations taken and write them "
+                             "to this profile file when the program exits"),
+                    cl::init(""));
+
+static cl::opt<std::string>
+    ProfileUse("profile-use",
+               cl::desc("Weight branches with the counts of this profile file"),
+               cl::init(""));
+
+// Option for bounding the run time of untrusted programs.
+static cl::opt<unsigned>
+    Fuel("fuel",
+         cl::desc("Stop the program with exit status 124 when its fuel runs out. Fuel units: "
+                  "one per loop iteration plus one per 256 top-level statement nodes, an if "
+                  "counting all its arms (0 is unlimited, at most 2147483647)"),
+         cl::init(0));
+
+// Options for evaluating programs in the compiler.
+static cl::opt<bool>
+    Precompute("precompute",
+               cl::desc("Evaluate programs in the compiler and only write their output "
+                        "at run time if they finish within the budgets"),
+               cl::init(false));
+
+static cl::opt<unsigned>
+    PrecomputeBudget("precompute-budget",
+                     cl::desc("Maximum number of expression nodes evaluated in the compiler"),
+                     cl::init(10000000));
+
+static cl::opt<unsigned>
+    PrecomputeMaxOutput("precompute-max-output",
+                        cl::desc("Maximum size in bytes of the output of a precomputed program"),
+                        cl::init(1 << 20));
+
+// Define a visitor class for generating LLVM IR from the AST.
+namespace
+{
+  // The fuel left to a metered program is kept like a variable, so that it
+  // lives in a register. The name cannot clash with a GSM identifier.
+  const char *const FuelVar = "gsm.fuel";
+
+  // Straight-line code is charged one unit of fuel per this many nodes.
+  const unsigned FuelBlockNodes = 256;
+
+  class ToIRVisitor : public ASTVisitor
+  {
+    Module *M;
+    IRBuilder<> Builder;
+    Type *VoidTy;
+    Type *Int32Ty;
+    Type *Int8PtrTy;
+    Type *Int8PtrPtrTy;
+    Constant *Int32Zero;
+
+    Value *V;
+    Function *CurFn;            // function being generated
+    FunctionCallee WriteFn; // gsm_write runtime function
+    FunctionCallee FlushFn; // gsm_flush runtime function
+    FunctionCallee FuelFn;  // gsm_fuel_exhausted runtime function
+    Function *PowFn;        // helper for ^ with a run time exponent
+
+    // Variables live in SSA registers. The current definition of each variable
+    // is tracked per basic block, and phis are created on the fly while reading
+    // variables (Braun et al., "Simple and Efficient Construction of Static
+    // Single Assignment Form").
+    struct BasicBlockDef
+    {
+      // Current definition of each variable in the block.
+      DenseMap<StringRef, TrackingVH<Value>> Defs;
+      // Phis created while not all predecessors of the block were known.
+      DenseMap<PHINode *, StringRef> IncompletePhis;
+      // Set once no more predecessors are added to the block.
+      unsigned Sealed : 1;
+
+      BasicBlockDef() : Sealed(0) {}
+    };
+
+    DenseMap<BasicBlock *, BasicBlockDef> CurrentDef;
+
+    // With -split-functions, the top-level statements are put into internal
+    // functions called from main in order. Variables live in a frame of i32
+    // slots allocated by main: a part loads a variable from its slot when it
+    // reads it before writing it, and stores the variables it changed before
+    // it returns. Frame is null while main is generated alone. The chunks
+    // of a streamed program are parts in modules of their own, which share
+    // the slots through the CodeGen.
+    Value *Frame;
+    MapVector<StringRef, unsigned> &FrameSlots; // slot of every variable
+    DenseMap<StringRef, LoadInst *> FrameLoads; // loads in the current part
+    SetVector<StringRef> FrameWrites;           // writes in the current part
+
+    // What the semantic checks found out about the tree: the size and cost
+    // of its nodes, and its profile counters.
+    const NodeFacts &Nodes;
+    const ProfileCounters &Shape;
+
+    // Profile counters: with -profile-generate, Counters is the array the
+    // instrumented program counts in; with -profile-use, Prof holds the
+    // counts read back if they match the program.
+    GlobalVariable *Counters;
+    std::unique_ptr<Profile> Prof;
+
+    // Debug information with -g: every function of the program gets a
+    // subprogram in the compile unit of the source file, and instructions
+    // get the line and column of the AST node they were generated for.
+    // Tools that map machine code back to the statements ask for the line
+    // table alone.
+    std::unique_ptr<DIBuilder> DBuilder;
+    DIFile *File;
+    bool LineInfo;
+    bool Remarks; // optimization remarks are reported for the module
+
+    void writeVariable(BasicBlock *BB, StringRef Var, Value *Val)
+    {
+      CurrentDef[BB].Defs[Var] = Val;
+      if (Frame)
+        FrameWrites.insert(Var);
+    }
+
+    Value *readVariable(BasicBlock *BB, StringRef Var)
+    {
+      auto Val = CurrentDef[BB].Defs.find(Var);
+      if (Val != CurrentDef[BB].Defs.end())
+        return Val->second;
+      return readVariableRecursive(BB, Var);
+    }
+
+    Value *readVariableRecursive(BasicBlock *BB, StringRef Var)
+    {
+      Value *Val = nullptr;
+      if (!CurrentDef[BB].Sealed)
+      {
+        // Predecessors are still missing: complete the phi when sealing.
+        PHINode *Phi = addEmptyPhi(BB);
+        CurrentDef[BB].IncompletePhis[Phi] = Var;
+        Val = Phi;
+      }
+      else if (BasicBlock *PredBB = BB->getSinglePredecessor())
+      {
+        // No phi is needed for a single predecessor.
+        Val = readVariable(PredBB, Var);
+      }
+      else if (pred_empty(BB))
+      {
+        // Read before any write reaches the block, the entry of a part
+        // takes the value from the frame.
+        Val = Frame ? loadFromFrame(BB, Var) : UndefValue::get(Int32Ty);
+      }
+      else
+      {
+        // Record the phi first to break cycles through loops.
+        PHINode *Phi = addEmptyPhi(BB);
+        CurrentDef[BB].Defs[Var] = Phi;
+        Val = addPhiOperands(BB, Var, Phi);
+      }
+      CurrentDef[BB].Defs[Var] = Val;
+      return Val;
+    }
+
+    PHINode *addEmptyPhi(BasicBlock *BB)
+    {
+      return BB->empty() ? PHINode::Create(Int32Ty, 0, "", BB)
+                         : PHINode::Create(Int32Ty, 0, "", &BB->front());
+    }
+
+    Value *addPhiOperands(BasicBlock *BB, StringRef Var, PHINode *Phi)
+    {
+      for (BasicBlock *PredBB : predecessors(BB))
+        Phi->addIncoming(readVariable(PredBB, Var), PredBB);
+      return tryRemoveTrivialPhi(Phi);
+    }
+
+    // Replace a phi whose operands are all the same value (or the phi itself)
+    // by that value, then retry the phis that used it.
+    Value *tryRemoveTrivialPhi(PHINode *Phi)
+    {
+      Value *Same = nullptr;
+      for (Value *Op : Phi->incoming_values())
+      {
+        if (Op == Same || Op == Phi)
+          continue;
+        if (Same)
+          return Phi;
+        Same = Op;
+      }
+      if (!Same)
+        Same = UndefValue::get(Phi->getType());
+
+      SmallVector<WeakVH, 8> Users;
+      for (User *U : Phi->users())
+      {
+        if (auto *P = dyn_cast<PHINode>(U))
+          if (P != Phi)
+            Users.push_back(P);
+      }
+      Phi->replaceAllUsesWith(Same);
+      Phi->eraseFromParent();
+
+      // Users may already be gone, and incomplete phis must stay until sealed.
+      for (WeakVH &U : Users)
+      {
+        auto *P = dyn_cast_or_null<PHINode>(U);
+        if (P && CurrentDef[P->getParent()].Sealed)
+          tryRemoveTrivialPhi(P);
+      }
+      return Same;
+    }
+
+    // Return a pointer to the frame slot of the variable.
+    Value *getFrameSlot(IRBuilder<> &B, StringRef Var)
+    {
+      auto Slot = FrameSlots.insert({Var, FrameSlots.size()}).first->second;
+      return B.CreateConstInBoundsGEP1_32(Int32Ty, Frame, Slot, Var + ".slot");
+    }
+
+    // Load the value of the variable at the start of the entry block.
+    Value *loadFromFrame(BasicBlock *Entry, StringRef Var)
+    {
+      IRBuilder<> B(Entry, Entry->getFirstInsertionPt());
+      LoadInst *Load = B.CreateLoad(Int32Ty, getFrameSlot(B, Var), Var);
+      FrameLoads[Var] = Load;
+      return Load;
+    }
+
+    // Generate the statements as a function taking the frame, and return it.
+    Function *createPart(ArrayRef<Expr *> Stmts, const Twine &Name,
+                         GlobalValue::LinkageTypes Linkage)
+    {
+      LLVMContext &Ctx = M->getContext();
+      FunctionType *PartTy = FunctionType::get(VoidTy, {Int32Ty->getPointerTo()}, false);
+      CurFn = Function::Create(PartTy, Linkage, Name, M);
+      // Inlining the parts back into main would undo the partitioning.
+      CurFn->addFnAttr(Attribute::NoInline);
+      CurFn->addFnAttr(Attribute::NoUnwind);
+      attachSubprogram(CurFn, Stmts.front()->getLoc().Line);
+      Frame = CurFn->getArg(0);
+      Frame->setName("frame");
+      FrameLoads.clear();
+      FrameWrites.clear();
+
+      BasicBlock *BB = BasicBlock::Create(Ctx, "entry", CurFn);
+      sealBlock(BB);
+      Builder.SetInsertPoint(BB);
+      visitStatements(Stmts);
+      clearLocation();
+
+      // Store back the variables the part wrote, unless they still hold
+      // the value loaded on entry, and drop the loads nothing used.
+      BasicBlock *ExitBB = Builder.GetInsertBlock();
+      SmallVector<StringRef, 16> Writes(FrameWrites.begin(), FrameWrites.end());
+      for (StringRef Var : Writes)
+      {
+        Value *Val = readVariable(ExitBB, Var);
+        if (Val != FrameLoads.lookup(Var))
+          Builder.CreateStore(Val, getFrameSlot(Builder, Var));
+      }
+      for (auto &VarLoad : FrameLoads)
+      {
+        LoadInst *Load = VarLoad.second;
+        auto *Slot = dyn_cast<Instruction>(Load->getPointerOperand());
+        if (!Load->use_empty())
+          continue;
+        Load->eraseFromParent();
+        if (Slot && Slot->use_empty())
+          Slot->eraseFromParent();
+      }
+      Builder.CreateRetVoid();
+      return CurFn;
+    }
+
+    // Generate the program as a sequence of parts of about SplitFunctions
+    // nodes each, and the calls to them from main. Returns false if the
+    // program fits into a single part.
+    bool splitIntoParts(GSM &Node)
+    {
+      SmallVector<Expr *> Stmts = Node.getExprs();
+      SmallVector<unsigned, 8> Bounds = {0};
+      unsigned Size = 0;
+      for (unsigned I = 0, E = Stmts.size(); I != E; ++I)
+      {
+        Size += Nodes.getSize(Stmts[I]);
+        if (Size >= SplitFunctions && I + 1 != E)
+        {
+          Bounds.push_back(I + 1);
+          Size = 0;
+        }
+      }
+      if (Bounds.size() < 2)
+        return false;
+      Bounds.push_back(Stmts.size());
+
+      Function *MainFn = CurFn;
+      BasicBlock *MainBB = Builder.GetInsertBlock();
+      SmallVector<Function *, 8> Parts;
+      for (unsigned I = 0, E = Bounds.size() - 1; I != E; ++I)
+        Parts.push_back(createPart(makeArrayRef(Stmts).slice(Bounds[I], Bounds[I + 1] - Bounds[I]),
+                                   "gsm.part." + Twine(I), GlobalValue::InternalLinkage));
+
+      // The frame has a slot for every variable of the program.
+      CurFn = MainFn;
+      Frame = nullptr;
+      Builder.SetInsertPoint(MainBB);
+      Builder.SetCurrentDebugLocation(DebugLoc());
+      Value *FramePtr = createFrame();
+      for (unsigned I = 0, E = Parts.size(); I != E; ++I)
+      {
+        emitLocation(*Stmts[Bounds[I]]);
+        Builder.CreateCall(Parts[I], {FramePtr});
+      }
+      return true;
+    }
+
+    // Allocate the frame in main, with a slot for every variable the parts
+    // use, and return a pointer to its first slot. The fuel of a metered
+    // program starts out in its slot.
+    Value *createFrame()
+    {
+      if (Fuel)
+        FrameSlots.insert({FuelVar, FrameSlots.size()});
+      Type *FrameTy = ArrayType::get(Int32Ty, std::max<size_t>(FrameSlots.size(), 1));
+      Value *FrameArray = Builder.CreateAlloca(FrameTy, nullptr, "frame");
+      Value *FramePtr = Builder.CreateConstInBoundsGEP2_32(FrameTy, FrameArray, 0, 0);
+      if (Fuel)
+        Builder.CreateStore(getFuelBudget(),
+                            Builder.CreateConstInBoundsGEP1_32(Int32Ty, FramePtr,
+                                                               FrameSlots.lookup(FuelVar)));
+      return FramePtr;
+    }
+
+    // Generate top-level statements. With -fuel, straight-line code is
+    // charged one unit at its start and another one every FuelBlockNodes
+    // nodes, so that huge programs without loops are bounded as well. An if
+    // is charged for the nodes of all its arms, whichever one runs, and a
+    // loop for the nodes of its body once; its iterations cost one unit
+    // each. A program whose first statements start a loop of N iterations
+    // therefore needs N + 1 units.
+    void visitStatements(ArrayRef<Expr *> Stmts)
+    {
+      unsigned Size = FuelBlockNodes;
+      for (Expr *S : Stmts)
+      {
+        if (Fuel && Size >= FuelBlockNodes)
+        {
+          emitLocation(*S);
+          chargeFuel();
+          Size = 0;
+        }
+        Size += Nodes.getSize(S);
+        S->accept(*this);
+      }
+    }
+
+    Constant *getFuelBudget()
+    {
+      return ConstantInt::get(Int32Ty, std::min<unsigned>(Fuel, INT32_MAX));
+    }
+
+    // Charge one unit of fuel, stopping the program if none is left.
+    void chargeFuel()
+    {
+      Value *Left = readVariable(Builder.GetInsertBlock(), FuelVar);
+      exitIfOutOfFuel(Builder.CreateICmpSLE(Left, Int32Zero));
+      writeVariable(Builder.GetInsertBlock(), FuelVar,
+                    Builder.CreateNSWSub(Left, ConstantInt::get(Int32Ty, 1)));
+    }
+
+    // Branch to the cold exit of a metered program if the condition holds,
+    // and continue in a new block otherwise.
+    void exitIfOutOfFuel(Value *Out)
+    {
+      LLVMContext &Ctx = M->getContext();
+      BasicBlock *TrapBB = BasicBlock::Create(Ctx, "fuel.out", CurFn);
+      BasicBlock *ContBB = BasicBlock::Create(Ctx, "fuel.ok", CurFn);
+      // The weights of __builtin_expect: the exit is taken once at most.
+      Builder.CreateCondBr(Out, TrapBB, ContBB, MDBuilder(Ctx).createBranchWeights(1, (1U << 20) - 1));
+      sealBlock(TrapBB);
+      sealBlock(ContBB);
+
+      // gsm_fuel_exhausted flushes the buffer of the runtime library, which
+      // is not the one a module with the runtime linked in writes to.
+      Builder.SetInsertPoint(TrapBB);
+      Builder.CreateCall(FlushFn);
+      Builder.CreateCall(FuelFn);
+      Builder.CreateUnreachable();
+      Builder.SetInsertPoint(ContBB);
+    }
+
+    // Give the function a subprogram starting at the line.
+    void attachSubprogram(Function *F, unsigned Line)
+    {
+      if (!DBuilder)
+        return;
+      DISubroutineType *Ty = DBuilder->createSubroutineType(DBuilder->getOrCreateTypeArray({}));
+      DISubprogram::DISPFlags Flags = DISubprogram::SPFlagDefinition;
+      if (F->hasLocalLinkage())
+        Flags |= DISubprogram::SPFlagLocalToUnit;
+      F->setSubprogram(DBuilder->createFunction(File, F->getName(), F->getName(), File, Line, Ty,
+                                                Line, DINode::FlagPrototyped, Flags));
+      Builder.SetCurrentDebugLocation(DebugLoc());
+    }
+
+    // Attribute the instructions created next to the node.
+    void emitLocation(Expr &Node)
+    {
+      if (!DBuilder || !Node.getLoc().Line)
+        return;
+      Builder.SetCurrentDebugLocation(DILocation::get(M->getContext(), Node.getLoc().Line,
+                                                      Node.getLoc().Col, CurFn->getSubprogram()));
+    }
+
+    // Attribute the instructions created next to no statement, like the
+    // code that runs after the last one.
+    void clearLocation()
+    {
+      if (DBuilder)
+        Builder.SetCurrentDebugLocation(DILocation::get(M->getContext(), 0, 0,
+                                                        CurFn->getSubprogram()));
+    }
+
+    // Count one execution of the counter at the insertion point.
+    void increment(unsigned Idx)
+    {
+      Type *Int64Ty = Builder.getInt64Ty();
+      Value *Ptr = Builder.CreateConstInBoundsGEP2_32(Counters->getValueType(), Counters, 0, Idx);
+      Value *Count = Builder.CreateLoad(Int64Ty, Ptr);
+      Builder.CreateStore(Builder.CreateAdd(Count, ConstantInt::get(Int64Ty, 1)), Ptr);
+    }
+
+    // Return the counts of the node's counters, empty without a profile.
+    ArrayRef<uint64_t> getCounts(Expr &Node, unsigned N)
+    {
+      if (!Prof)
+        return {};
+      return Prof->getCounts().slice(Shape.First.lookup(&Node), N);
+    }
+
+    // Return branch weights for the successors taken the given number of
+    // times, scaled to 32 bits. Every weight is at least 1, so a branch
+    // that was never taken is unlikely but not impossible.
+    MDNode *getWeights(ArrayRef<uint64_t> Counts)
+    {
+      uint64_t Max = *std::max_element(Counts.begin(), Counts.end());
+      uint64_t Scale = Max < UINT32_MAX ? 1 : Max / UINT32_MAX + 1;
+      SmallVector<uint32_t, 4> Weights;
+      for (uint64_t C : Counts)
+        Weights.push_back(C / Scale + 1);
+      return MDBuilder(M->getContext()).createBranchWeights(Weights);
+    }
+
+    // Return the weights of arm I of an if against the arms after it.
+    MDNode *getArmWeights(ArrayRef<uint64_t> Counts, unsigned I)
+    {
+      if (Counts.empty())
+        return nullptr;
+      uint64_t Rest = 0;
+      for (uint64_t C : Counts.drop_front(I + 1))
+        Rest += C;
+      return getWeights({Counts[I], Rest});
+    }
+
+    // Convert a truth value to an i32 where a number is expected.
+    Value *toInt(Value *Val)
+    {
+      if (Val->getType()->isIntegerTy(1))
+        return Builder.CreateZExt(Val, Int32Ty);
+      return Val;
+    }
+
+    // Convert a value to an i1 for use as a branch condition.
+    Value *toBool(Value *Val)
+    {
+      if (Val->getType()->isIntegerTy(1))
+        return Val;
+      return Builder.CreateICmpNE(Val, ConstantInt::get(Val->getType(), 0));
+    }
+
+    // Lower x ^ N for a constant N by square-and-multiply, which takes
+    // O(log N) multiplications. Exponents below 1 give 1.
+    Value *createPowConst(Value *Base, int64_t N)
+    {
+      Value *Result = nullptr;
+      Value *Square = Base;
+      for (uint64_t E = N > 0 ? N : 0; E; E >>= 1)
+      {
+        if (E & 1)
+          Result = Result ? Builder.CreateMul(Result, Square) : Square;
+        if (E >> 1)
+          Square = Builder.CreateMul(Square, Square);
+      }
+      return Result ? Result : ConstantInt::get(Int32Ty, 1, true);
+    }
+
+    // Return the helper computing base ^ exp for exponents only known at run
+    // time, creating it on first use. Exponents 0, 1 and 2 are answered
+    // directly, larger ones by a square-and-multiply loop.
+    Function *getPowFn()
+    {
+      if (PowFn)
+        return PowFn;
+
+      LLVMContext &Ctx = M->getContext();
+      FunctionType *PowTy = FunctionType::get(Int32Ty, {Int32Ty, Int32Ty}, false);
+      PowFn = Function::Create(PowTy, GlobalValue::InternalLinkage, "gsm.pow", M);
+      PowFn->addFnAttr(Attribute::NoUnwind);
+      PowFn->addFnAttr(Attribute::ReadNone);
+      Argument *Base = PowFn->getArg(0);
+      Argument *Exp = PowFn->getArg(1);
+
+      BasicBlock *Entry = BasicBlock::Create(Ctx, "entry", PowFn);
+      BasicBlock *RetOne = BasicBlock::Create(Ctx, "exp.zero", PowFn);
+      BasicBlock *RetBase = BasicBlock::Create(Ctx, "exp.one", PowFn);
+      BasicBlock *RetSquare = BasicBlock::Create(Ctx, "exp.two", PowFn);
+      BasicBlock *Loop = BasicBlock::Create(Ctx, "pow.loop", PowFn);
+      BasicBlock *Exit = BasicBlock::Create(Ctx, "pow.exit", PowFn);
+      IRBuilder<> B(Entry);
+
+      // Negative exponents take the default path and give 1 like 0 does.
+      Value *One = ConstantInt::get(Int32Ty, 1, true);
+      Value *IsPositive = B.CreateICmpSGT(Exp, Int32Zero);
+      BasicBlock *Dispatch = BasicBlock::Create(Ctx, "exp.dispatch", PowFn, RetOne);
+      B.CreateCondBr(IsPositive, Dispatch, RetOne);
+
+      B.SetInsertPoint(Dispatch);
+      SwitchInst *Switch = B.CreateSwitch(Exp, Loop, 2);
+      Switch->addCase(ConstantInt::get(Type::getInt32Ty(Ctx), 1), RetBase);
+      Switch->addCase(ConstantInt::get(Type::getInt32Ty(Ctx), 2), RetSquare);
+
+      B.SetInsertPoint(RetOne);
+      B.CreateRet(One);
+      B.SetInsertPoint(RetBase);
+      B.CreateRet(Base);
+      B.SetInsertPoint(RetSquare);
+      B.CreateRet(B.CreateMul(Base, Base));
+
+      // result *= square when the low bit is set; square *= square; exp >>= 1
+      B.SetInsertPoint(Loop);
+      PHINode *Result = B.CreatePHI(Int32Ty, 2, "result");
+      PHINode *Square = B.CreatePHI(Int32Ty, 2, "square");
+      PHINode *E = B.CreatePHI(Int32Ty, 2, "exp");
+      Value *Odd = B.CreateTrunc(E, Type::getInt1Ty(Ctx));
+      Value *NextResult = B.CreateSelect(Odd, B.CreateMul(Result, Square), Result);
+      Value *NextSquare = B.CreateMul(Square, Square);
+      Value *NextE = B.CreateLShr(E, 1);
+      B.CreateCondBr(B.CreateICmpEQ(NextE, Int32Zero), Exit, Loop);
+      Result->addIncoming(One, Dispatch);
+      Result->addIncoming(NextResult, Loop);
+      Square->addIncoming(Base, Dispatch);
+      Square->addIncoming(NextSquare, Loop);
+      E->addIncoming(Exp, Dispatch);
+      E->addIncoming(NextE, Loop);
+
+      B.SetInsertPoint(Exit);
+      B.CreateRet(NextResult);
+      return PowFn;
+    }
+
+    // Called once all predecessors of the block are known.
+    void sealBlock(BasicBlock *BB)
+    {
+      BasicBlockDef &Def = CurrentDef[BB];
+      Def.Sealed = 1;
+      SmallVector<std::pair<PHINode *, StringRef>, 8> Phis(Def.IncompletePhis.begin(),
+                                                          Def.IncompletePhis.end());
+      Def.IncompletePhis.clear();
+      for (auto &PhiVar : Phis)
+        addPhiOperands(BB, PhiVar.second, PhiVar.first);
+    }
+
+  public:
+    // Constructor for the visitor class.
+    ToIRVisitor(Module *M, StringRef FileName, const TreeFacts &Facts,
+                MapVector<StringRef, unsigned> &FrameSlots, bool LineInfo)
+        : M(M), Builder(M->getContext()), PowFn(nullptr), Frame(nullptr), FrameSlots(FrameSlots),
+          Nodes(Facts.Nodes), Shape(Facts.Shape), Counters(nullptr), File(nullptr), LineInfo(LineInfo), Remarks(false)
+    {
+      // Initialize LLVM types and constants.
+      VoidTy = Type::getVoidTy(M->getContext());
+      Int32Ty = Type::getInt32Ty(M->getContext());
+      Int8PtrTy = Type::getInt8PtrTy(M->getContext());
+      Int8PtrPtrTy = Int8PtrTy->getPointerTo();
+      Int32Zero = ConstantInt::get(Int32Ty, 0, true);
+
+      // Declare the runtime functions once per module.
+      WriteFn = M->getOrInsertFunction("gsm_write", FunctionType::get(VoidTy, {Int32Ty}, false));
+      FlushFn = M->getOrInsertFunction("gsm_flush", FunctionType::get(VoidTy, false));
+      if (Fuel)
+      {
+        AttributeList Attrs = AttributeList().addFnAttribute(M->getContext(), Attribute::NoReturn)
+                                  .addFnAttribute(M->getContext(), Attribute::Cold);
+        FuelFn = M->getOrInsertFunction("gsm_fuel_exhausted", Attrs, VoidTy);
+      }
+
+      // GSM has no DWARF language code of its own. Optimization remarks
+      // refer to the positions of instructions, so positions are tracked
+      // without emitting DWARF if remarks are enabled.
+      LLVMContext &Ctx = M->getContext();
+      Remarks = Ctx.getDiagHandlerPtr()->isAnyRemarkEnabled() || Ctx.getLLVMRemarkStreamer();
+      if (DebugInfo || LineInfo || Remarks)
+      {
+        DBuilder = std::make_unique<DIBuilder>(*M);
+        File = DBuilder->createFile(sys::path::filename(FileName), sys::path::parent_path(FileName));
+        DBuilder->createCompileUnit(dwarf::DW_LANG_C, File, "gsm", false, "", 0, StringRef(),
+                                    DebugInfo  ? DICompileUnit::FullDebug
+                                    : LineInfo ? DICompileUnit::LineTablesOnly
+                                               : DICompileUnit::NoDebug);
+        M->addModuleFlag(Module::Warning, "Dwarf Version", 4);
+        M->addModuleFlag(Module::Warning, "Debug Info Version", DEBUG_METADATA_VERSION);
+      }
+    }
+
+    // Entry point for generating LLVM IR from the AST.
+    void run(AST *Tree)
+    {
+      // Either create the profile counters or read them.
+      if (!ProfileGenerate.empty())
+      {
+        Type *CountersTy = ArrayType::get(Type::getInt64Ty(M->getContext()), Shape.NumCounters);
+        Counters = new GlobalVariable(*M, CountersTy, false, GlobalValue::InternalLinkage,
+                                      Constant::getNullValue(CountersTy), "gsm.prof.counters");
+      }
+      else if (!ProfileUse.empty())
+      {
+        Prof = Profile::read(ProfileUse);
+        if (Prof && (Prof->getHash() != Shape.getHash() ||
+                     Prof->getCounts().size() != Shape.NumCounters))
+        {
+          errs() << "Profile " << ProfileUse << " does not match the program, ignoring it\n";
+          Prof.reset();
+        }
+      }
+
+      if (tryPrecompute(Tree))
+        return;
+
+      createMain();
+      if (Fuel)
+        writeVariable(Builder.GetInsertBlock(), FuelVar, getFuelBudget());
+
+      // Visit the root node of the AST to generate IR.
+      Tree->accept(*this);
+      clearLocation();
+
+      // Flush the buffered output and return from the main function. An
+      // instrumented program writes its profile last.
+      Builder.CreateCall(FlushFn);
+      if (Counters)
+      {
+        Type *Int64Ty = Builder.getInt64Ty();
+        FunctionCallee ProfileWriteFn = M->getOrInsertFunction(
+            "gsm_profile_write",
+            FunctionType::get(VoidTy, {Int8PtrTy, Int64Ty, Int64Ty->getPointerTo(), Int32Ty}, false));
+        Builder.CreateCall(ProfileWriteFn,
+                           {Builder.CreateGlobalStringPtr(ProfileGenerate, "gsm.prof.file"),
+                            ConstantInt::get(Int64Ty, Shape.getHash()),
+                            Builder.CreateConstInBoundsGEP2_32(Counters->getValueType(), Counters, 0, 0),
+                            ConstantInt::get(Int32Ty, Shape.NumCounters)});
+      }
+      Builder.CreateRet(Int32Zero);
+
+      if (DBuilder)
+        DBuilder->finalize();
+    }
+
+    // Evaluate the program in the compiler and generate a main that writes
+    // its output with a single call. Metered, instrumented and debugged
+    // programs are compiled as they are, and so are programs whose
+    // optimizations are reported. Returns false if the program is not
+    // evaluated.
+    bool tryPrecompute(AST *Tree)
+    {
+      if (!Precompute || Fuel || Counters || DebugInfo || LineInfo || Remarks)
+        return false;
+      Evaluator Eval(PrecomputeBudget, PrecomputeMaxOutput);
+      if (!Eval.run(Tree))
+        return false;
+
+      createMain();
+      const std::string &Output = Eval.getOutput();
+      if (!Output.empty())
+      {
+        Type *Int64Ty = Builder.getInt64Ty();
+        FunctionCallee WriteTextFn = M->getOrInsertFunction(
+            "gsm_write_text", FunctionType::get(VoidTy, {Int8PtrTy, Int64Ty}, false));
+        Constant *Text = ConstantDataArray::getString(M->getContext(), Output, false);
+        auto *Global = new GlobalVariable(*M, Text->getType(), true, GlobalValue::PrivateLinkage,
+                                          Text, "gsm.output");
+        Global->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+        Global->setAlignment(Align(1));
+        Builder.CreateCall(WriteTextFn,
+                           {Builder.CreateConstInBoundsGEP2_32(Text->getType(), Global, 0, 0),
+                            ConstantInt::get(Int64Ty, Output.size())});
+      }
+      Builder.CreateRet(Int32Zero);
+
+      if (DBuilder)
+        DBuilder->finalize();
+      return true;
+    }
+
+    // Generate a chunk of a streamed program as the function gsm.chunk.<Idx>,
+    // which the main of the program calls with the frame.
+    void runChunk(AST *Tree, unsigned Idx)
+    {
+      createPart(static_cast<GSM *>(Tree)->getExprs(), "gsm.chunk." + Twine(Idx),
+                 GlobalValue::ExternalLinkage);
+      CurFn->setVisibility(GlobalValue::HiddenVisibility);
+      if (DBuilder)
+        DBuilder->finalize();
+    }
+
+    // Generate the main of a streamed program: it allocates the frame with
+    // the slots of all chunks and calls the chunks in order.
+    void runStreamMain(unsigned NumChunks)
+    {
+      createMain();
+      Value *FramePtr = createFrame();
+      FunctionType *ChunkTy = FunctionType::get(VoidTy, {Int32Ty->getPointerTo()}, false);
+      for (unsigned I = 0; I != NumChunks; ++I)
+      {
+        Function *Chunk = Function::Create(ChunkTy, GlobalValue::ExternalLinkage,
+                                           "gsm.chunk." + Twine(I), M);
+        Chunk->setVisibility(GlobalValue::HiddenVisibility);
+        Builder.CreateCall(Chunk, {FramePtr});
+      }
+      Builder.CreateCall(FlushFn);
+      Builder.CreateRet(Int32Zero);
+
+      if (DBuilder)
+        DBuilder->finalize();
+    }
+
+    // Create main and its entry block, and generate code at its start.
+    void createMain()
+    {
+      FunctionType *MainFty = FunctionType::get(Int32Ty, {Int32Ty, Int8PtrPtrTy}, false);
+      CurFn = Function::Create(MainFty, GlobalValue::ExternalLinkage, "main", M);
+      attachSubprogram(CurFn, 1);
+
+      BasicBlock *BB = BasicBlock::Create(M->getContext(), "entry", CurFn);
+      sealBlock(BB);
+      Builder.SetInsertPoint(BB);
+    }
+
+    // Visit function for the Goal node in the AST.
+    virtual void visit(GSM &Node) override
+    {
+      if (SplitFunctions && splitIntoParts(Node))
+        return;
+
+      // Iterate over the children of the Goal node and visit each child.
+      visitStatements(Node.getExprs());
+    };
+
+    virtual void visit(Assignment &Node) override
+    {
+      // Visit the right-hand side of the assignment and get its value.
+      Node.getRight()->accept(*this);
+      Value *val = toInt(V);
+
+      // Get the name of the variable being assigned.
+      auto varName = Node.getLeft()->getVal();
+      emitLocation(Node);
+
+      // The value becomes the current definition of the variable.
+      writeVariable(Builder.GetInsertBlock(), varName, val);
+
+      // Create a call instruction to invoke the "gsm_write" function with the value.
+      Builder.CreateCall(WriteFn, {val});
+    };
+
+    virtual void visit(Factor &Node) override
+    {
+      if (Node.getKind() == Factor::Ident)
+      {
+        // If the factor is an identifier, use its current definition.
+        V = readVariable(Builder.GetInsertBlock(), Node.getVal());
+      }
+      else
+      {
+        // If the factor is a literal, convert it to an integer and create a constant.
+        int intval;
+        Node.getVal().getAsInteger(10, intval);
+        V = ConstantInt::get(Int32Ty, intval, true);
+      }
+    };
+
+    virtual void visit(BinaryOp_Calculators &Node) override
+    {
+      // Visit the left-hand side of the binary operation and get its value.
+      Node.getLeft()->accept(*this);
+      Value *Left = toInt(V);
+
+      // Visit the right-hand side of the binary operation and get its value.
+      Node.getRight()->accept(*this);
+      Value *Right = toInt(V);
+      emitLocation(Node);
+
+      // Perform the binary operation based on the operator type and create the corresponding instruction.
+      switch (Node.getOperator())
+      {
+      case BinaryOp_Calculators::Plus:
+        V = Builder.CreateNSWAdd(Left, Right);
+        break;
+      case BinaryOp_Calculators::Minus:
+        V = Builder.CreateNSWSub(Left, Right);
+        break;
+      case BinaryOp_Calculators::Mul:
+        V = Builder.CreateNSWMul(Left, Right);
+        break;
+      case BinaryOp_Calculators::Div:
+        V = Builder.CreateSDiv(Left, Right);
+        break;
+      case BinaryOp_Calculators::Percent:
+        V = Builder.CreateSRem(Left, Right);
+        break;
+      case BinaryOp_Calculators::Power:
+        // A constant exponent is lowered inline, any other one calls the helper.
+        if (auto *Exp = dyn_cast<ConstantInt>(Right))
+          V = createPowConst(Left, Exp->getSExtValue());
+        else
+          V = Builder.CreateCall(getPowFn(), {Left, Right});
+        break;
+      }
+    };
+
+    // and/or produce an i1. The right-hand side is only evaluated if the left
+    // one does not decide the result: a cheap right-hand side without side
+    // effects is evaluated anyway and combined with a select, any other one
+    // gets its own block.
+    virtual void visit(BinaryOp_Logical &Node) override
+    {
+      bool IsAnd = Node.getOperator() == BinaryOp_Logical::KW_AND;
+
+      // Visit the left-hand side of the binary operation and get its value.
+      Node.getLeft()->accept(*this);
+      Value *Left = toBool(V);
+      emitLocation(Node);
+
+      if (Nodes.isCheapAndSafe(Node.getRight()))
+      {
+        Node.getRight()->accept(*this);
+        Value *Right = toBool(V);
+        emitLocation(Node);
+        V = IsAnd ? Builder.CreateSelect(Left, Right, Builder.getFalse())
+                  : Builder.CreateSelect(Left, Builder.getTrue(), Right);
+        return;
+      }
+
+      LLVMContext &Ctx = M->getContext();
+      BasicBlock *LeftBB = Builder.GetInsertBlock();
+      BasicBlock *RightBB = BasicBlock::Create(Ctx, IsAnd ? "land.rhs" : "lor.rhs", CurFn);
+      BasicBlock *EndBB = BasicBlock::Create(Ctx, IsAnd ? "land.end" : "lor.end", CurFn);
+      if (IsAnd)
+        Builder.CreateCondBr(Left, RightBB, EndBB);
+      else
+        Builder.CreateCondBr(Left, EndBB, RightBB);
+      sealBlock(RightBB);
+
+      // Visit the right-hand side only on the path that needs it.
+      Builder.SetInsertPoint(RightBB);
+      Node.getRight()->accept(*this);
+      Value *Right = toBool(V);
+      emitLocation(Node);
+      RightBB = Builder.GetInsertBlock();
+      Builder.CreateBr(EndBB);
+      sealBlock(EndBB);
+
+      Builder.SetInsertPoint(EndBB);
+      PHINode *Phi = Builder.CreatePHI(Builder.getInt1Ty(), 2);
+      Phi->addIncoming(IsAnd ? Builder.getFalse() : Builder.getTrue(), LeftBB);
+      Phi->addIncoming(Right, RightBB);
+      V = Phi;
+    };
+
+    virtual void visit(BinaryOp_Attribution &Node) override
+    {
+      // Visit the left-hand side of the binary operation and get its value.
+      Node.getLeft()->accept(*this);
+      Value *Left = toInt(V);
+      
+      // Visit the right-hand side of the binary operation and get its value.
+      Node.getRight()->accept(*this);
+      Value *Right = toInt(V);
+      emitLocation(Node);
+
+      // Perform the binary operation based on the operator type and create the corresponding instruction.
+      Value *Result = nullptr;
+      switch (Node.getOperator())
+      {
+      case BinaryOp_Attribution::Plus_equal:
+        Result = Builder.CreateNSWAdd(Left, Right);
+        break;
+      case BinaryOp_Attribution::Minus_equal:
+        Result = Builder.CreateNSWSub(Left, Right);
+        break;
+      case BinaryOp_Attribution::Slash_equal:
+        Result = Builder.CreateSDiv(Left, Right);
+        break;
+      case BinaryOp_Attribution::Star_equal:
+        Result = Builder.CreateNSWMul(Left, Right);
+        break;
+      }
+
+      // Assign the result back to the variable on the left.
+      if (auto *F = dyn_cast<Factor>(Node.getLeft()))
+      {
+        if (F->getKind() == Factor::Ident)
+          writeVariable(Builder.GetInsertBlock(), F->getVal(), Result);
+      }
+      V = Result;
+    };
+
+    // Lower if/elif/else into a chain of conditional branches. Each arm with a
+    // condition branches to its body or to the next arm, every body ends in
+    // the common merge block. A dispatch on one variable becomes a switch
+    // even if its arms are cheap enough for selects, which would evaluate
+    // every arm.
+    virtual void visit(Condition &Node) override
+    {
+      if (lowerToSwitch(Node) || lowerToSelects(Node))
+        return;
+
+      LLVMContext &Ctx = M->getContext();
+      BasicBlock *MergeBB = BasicBlock::Create(Ctx, "if.end", CurFn);
+      unsigned NumArms = Node.getArms().size();
+      bool HasElse = !Node.getArms().back().Cond;
+      unsigned Counter = Shape.First.lookup(&Node);
+      ArrayRef<uint64_t> Counts = getCounts(Node, NumArms + !HasElse);
+
+      for (unsigned I = 0; I != NumArms; ++I)
+      {
+        Condition::Arm &A = Node.getArms()[I];
+        if (A.Cond)
+        {
+          A.Cond->accept(*this);
+          emitLocation(Node);
+          BasicBlock *ThenBB = BasicBlock::Create(Ctx, "if.then", CurFn, MergeBB);
+          BasicBlock *NextBB = BasicBlock::Create(Ctx, "if.else", CurFn, MergeBB);
+          Builder.CreateCondBr(toBool(V), ThenBB, NextBB, getArmWeights(Counts, I));
+          sealBlock(ThenBB);
+          sealBlock(NextBB);
+
+          Builder.SetInsertPoint(ThenBB);
+          if (Counters)
+            increment(Counter + I);
+          for (Expr *S : A.Body)
+            S->accept(*this);
+          Builder.CreateBr(MergeBB);
+
+          // The next arm, or the fall through if there is none.
+          Builder.SetInsertPoint(NextBB);
+        }
+        else
+        {
+          if (Counters)
+            increment(Counter + I);
+          for (Expr *S : A.Body)
+            S->accept(*this);
+        }
+      }
+      if (Counters && !HasElse)
+        increment(Counter + NumArms);
+      Builder.CreateBr(MergeBB);
+      sealBlock(MergeBB);
+
+      Builder.SetInsertPoint(MergeBB);
+    };
+
+    // Lower an if/elif/else without branches if every arm assigns the same
+    // variables in the same order from cheap expressions without side effects
+    // and there is an else arm: all arms are evaluated, and each assigned
+    // value is picked with a select on the conditions. The output is the same
+    // since every arm writes the same number of values. Returns false if the
+    // condition does not qualify.
+    bool lowerToSelects(Condition &Node)
+    {
+      // Instrumented arms need blocks to count in.
+      Condition::ArmVector &Arms = Node.getArms();
+      if (!SelectIfs || Counters || Arms.size() < 2 || Arms.back().Cond)
+        return false;
+
+      // Everything evaluated must fit into the budget.
+      unsigned Budget = SelectIfThreshold;
+      SmallVector<Expr *> &First = Arms.front().Body;
+      for (Condition::Arm &A : Arms)
+      {
+        if (A.Body.size() != First.size())
+          return false;
+        if (A.Cond && !Nodes.isCheapAndSafe(A.Cond, Budget))
+          return false;
+        for (unsigned I = 0, E = A.Body.size(); I != E; ++I)
+        {
+          auto *Asg = dyn_cast<Assignment>(A.Body[I]);
+          if (!Asg || Asg->getLeft()->getVal() !=
+                          cast<Assignment>(First[I])->getLeft()->getVal())
+            return false;
+          if (!Nodes.isCheapAndSafe(Asg->getRight(), Budget))
+            return false;
+        }
+      }
+
+      // Evaluate all conditions up front.
+      BasicBlock *BB = Builder.GetInsertBlock();
+      SmallVector<Value *, 4> Conds;
+      for (Condition::Arm &A : Arms)
+      {
+        if (A.Cond)
+        {
+          A.Cond->accept(*this);
+          Conds.push_back(toBool(V));
+        }
+      }
+
+      // Every arm starts from the variables as they were before the if.
+      SmallVector<std::pair<StringRef, Value *>, 4> Before;
+      for (Expr *S : First)
+      {
+        StringRef Var = cast<Assignment>(S)->getLeft()->getVal();
+        Before.push_back({Var, readVariable(BB, Var)});
+      }
+
+      SmallVector<SmallVector<Value *, 4>, 4> Values(Arms.size());
+      for (unsigned A = 0, E = Arms.size(); A != E; ++A)
+      {
+        for (auto &VarVal : Before)
+          writeVariable(BB, VarVal.first, VarVal.second);
+        for (Expr *S : Arms[A].Body)
+        {
+          auto *Asg = cast<Assignment>(S);
+          Asg->getRight()->accept(*this);
+          Value *Val = toInt(V);
+          writeVariable(BB, Asg->getLeft()->getVal(), Val);
+          Values[A].push_back(Val);
+        }
+      }
+
+      // Pick each value from the first arm whose condition holds, and assign
+      // and write them in source order.
+      ArrayRef<uint64_t> Counts = getCounts(Node, Arms.size());
+      for (unsigned I = 0, E = First.size(); I != E; ++I)
+      {
+        emitLocation(*First[I]);
+        Value *Val = Values.back()[I];
+        for (unsigned A = Conds.size(); A-- > 0;)
+        {
+          Val = Builder.CreateSelect(Conds[A], Values[A][I], Val);
+          if (auto *Sel = dyn_cast<SelectInst>(Val))
+            Sel->setMetadata(LLVMContext::MD_prof, getArmWeights(Counts, A));
+        }
+        writeVariable(BB, cast<Assignment>(First[I])->getLeft()->getVal(), Val);
+        Builder.CreateCall(WriteFn, {Val});
+      }
+      return true;
+    }
+
+    // Return the literal if the condition compares a variable with an integer
+    // literal for equality, in either order. Var receives the variable.
+    static Optional<int> getEqualityCase(Expr *Cond, StringRef &Var)
+    {
+      auto *Rel = dyn_cast_or_null<BinaryOp_Relational>(Cond);
+      if (!Rel || Rel->getOperator() != BinaryOp_Relational::Equality)
+        return None;
+      auto *L = dyn_cast<Factor>(Rel->getLeft());
+      auto *R = dyn_cast<Factor>(Rel->getRight());
+      if (!L || !R || L->getKind() == R->getKind())
+        return None;
+      if (L->getKind() == Factor::Number)
+        std::swap(L, R);
+
+      int Val;
+      if (R->getVal().getAsInteger(10, Val))
+        return None;
+      Var = L->getVal();
+      return Val;
+    }
+
+    // Lower an if/elif chain whose conditions all compare the same variable
+    // with distinct integer literals to a single switch; the else arm becomes
+    // the default. Instruction selection turns dense switches into jump
+    // tables and sparse ones into balanced binary decision trees. Returns
+    // false if the chain does not qualify.
+    bool lowerToSwitch(Condition &Node)
+    {
+      StringRef Var;
+      SmallVector<int, 8> Cases;
+      DenseSet<int> Seen;
+      for (Condition::Arm &A : Node)
+      {
+        if (!A.Cond)
+          continue;
+        StringRef ArmVar;
+        Optional<int> Val = getEqualityCase(A.Cond, ArmVar);
+        if (!Val || (!Var.empty() && ArmVar != Var) || !Seen.insert(*Val).second)
+          return false;
+        Var = ArmVar;
+        Cases.push_back(*Val);
+      }
+      if (SwitchMinCases == 0 || Cases.size() < SwitchMinCases)
+        return false;
+
+      LLVMContext &Ctx = M->getContext();
+      BasicBlock *MergeBB = BasicBlock::Create(Ctx, "if.end", CurFn);
+      unsigned NumArms = Node.getArms().size();
+      bool HasElse = !Node.getArms().back().Cond;
+      unsigned Counter = Shape.First.lookup(&Node);
+      ArrayRef<uint64_t> Counts = getCounts(Node, NumArms + !HasElse);
+
+      // Taking no arm is counted in a default block of its own.
+      BasicBlock *DefaultBB =
+          HasElse || Counters ? BasicBlock::Create(Ctx, "switch.default", CurFn, MergeBB) : MergeBB;
+
+      emitLocation(Node);
+      Value *Selector = readVariable(Builder.GetInsertBlock(), Var);
+      SwitchInst *Switch = Builder.CreateSwitch(Selector, DefaultBB, Cases.size());
+
+      unsigned CaseIdx = 0;
+      for (unsigned I = 0; I != NumArms; ++I)
+      {
+        Condition::Arm &A = Node.getArms()[I];
+        BasicBlock *ArmBB = DefaultBB;
+        if (A.Cond)
+        {
+          ArmBB = BasicBlock::Create(Ctx, "switch.case", CurFn, DefaultBB);
+          Switch->addCase(ConstantInt::get(Type::getInt32Ty(Ctx), Cases[CaseIdx++]), ArmBB);
+        }
+        sealBlock(ArmBB);
+
+        Builder.SetInsertPoint(ArmBB);
+        if (Counters)
+          increment(Counter + I);
+        for (Expr *S : A.Body)
+          S->accept(*this);
+        Builder.CreateBr(MergeBB);
+      }
+      if (Counters && !HasElse)
+      {
+        sealBlock(DefaultBB);
+        Builder.SetInsertPoint(DefaultBB);
+        increment(Counter + NumArms);
+        Builder.CreateBr(MergeBB);
+      }
+      sealBlock(MergeBB);
+
+      // The weights of the default come first, then those of the cases.
+      if (!Counts.empty())
+      {
+        SmallVector<uint64_t, 8> Weights = {Counts[HasElse ? NumArms - 1 : NumArms]};
+        Weights.append(Counts.begin(), Counts.begin() + Cases.size());
+        Switch->setMetadata(LLVMContext::MD_prof, getWeights(Weights));
+      }
+
+      Builder.SetInsertPoint(MergeBB);
+      return true;
+    }
+
+    // Lower loopc into LLVM's canonical loop form: the current block is the
+    // preheader, the header evaluates the condition, the end of the body is
+    // the single latch and the exit is only reached from the header.
+    virtual void visit(Loop &Node) override
+    {
+      LLVMContext &Ctx = M->getContext();
+      BasicBlock *HeaderBB = BasicBlock::Create(Ctx, "loopc.header", CurFn);
+      BasicBlock *BodyBB = BasicBlock::Create(Ctx, "loopc.body", CurFn);
+      BasicBlock *ExitBB = BasicBlock::Create(Ctx, "loopc.exit", CurFn);
+
+      // The header is not sealed until the back edge from the latch exists.
+      unsigned Counter = Shape.First.lookup(&Node);
+      emitLocation(Node);
+      if (Counters)
+        increment(Counter);
+      Builder.CreateBr(HeaderBB);
+      Builder.SetInsertPoint(HeaderBB);
+      Node.getCond()->accept(*this);
+      Value *Cond = toBool(V);
+
+      // A metered loop also ends when the fuel runs out. Keeping that in the
+      // loop condition leaves the loop with a single exit and a computable
+      // trip count, so it can still be vectorized.
+      emitLocation(Node);
+      Value *Run = Cond;
+      if (Fuel)
+      {
+        Value *Left = readVariable(Builder.GetInsertBlock(), FuelVar);
+        Run = Builder.CreateAnd(Cond, Builder.CreateICmpSGT(Left, Int32Zero), "fuel.run");
+      }
+
+      // The loop is left once per entry, so the trip count is the number of
+      // body runs per entry.
+      ArrayRef<uint64_t> Counts = getCounts(Node, 2);
+      Builder.CreateCondBr(Run, BodyBB, ExitBB,
+                           Counts.empty() ? nullptr : getWeights({Counts[1], Counts[0]}));
+      sealBlock(BodyBB);
+      sealBlock(ExitBB);
+
+      Builder.SetInsertPoint(BodyBB);
+      if (Counters)
+        increment(Counter + 1);
+      for (auto I = Node.begin(), E = Node.end(); I != E; ++I)
+      {
+        (*I)->accept(*this);
+      }
+      if (Fuel)
+      {
+        BasicBlock *LatchBB = Builder.GetInsertBlock();
+        writeVariable(LatchBB, FuelVar,
+                      Builder.CreateNSWSub(readVariable(LatchBB, FuelVar), ConstantInt::get(Int32Ty, 1)));
+      }
+      Builder.CreateBr(HeaderBB);
+      sealBlock(HeaderBB);
+
+      // Leaving while the condition still holds means the fuel ran out.
+      Builder.SetInsertPoint(ExitBB);
+      if (Fuel)
+        exitIfOutOfFuel(Cond);
+    }
+
+    virtual void visit(BinaryOp_Relational &Node) override
+    {
+      // Visit the left-hand side of the binary operation and get its value.
+      Node.getLeft()->accept(*this);
+      Value *Left = toInt(V);
+
+      // Visit the right-hand side of the binary operation and get its value.
+      Node.getRight()->accept(*this);
+      Value *Right = toInt(V);
+      emitLocation(Node);
+
+      // Perform the binary operation based on the operator type and create the corresponding instruction.
+      switch (Node.getOperator())
+      {
+
+      case BinaryOp_Relational::Equality:
+        V = Builder.CreateICmpEQ(Left, Right);
+        break;
+
+      case BinaryOp_Relational::Not_equal:
+        V = Builder.CreateICmpNE(Left, Right);
+        break;
+
+      case BinaryOp_Relational::Greater_than_or_equal:
+        V = Builder.CreateICmpSGE(Left, Right);
+        break;
+
+      case BinaryOp_Relational::Less_than_or_equal:
+        V = Builder.CreateICmpSLE(Left, Right);
+        break;
+
+      case BinaryOp_Relational::Greater_than:
+        V = Builder.CreateICmpSGT(Left, Right);
+        break;
+
+      case BinaryOp_Relational::Less_than:
+        V = Builder.CreateICmpSLT(Left, Right);
+        break;
+      }
+    };
+
+    virtual void visit(Declaration &Node) override
+    {
+      Value *val = nullptr;
+
+      if (Node.getExpr())
+      {
+        // If there is an expression provided, visit it and get its value.
+        Node.getExpr()->accept(*this);
+        val = toInt(V);
+      }
+      emitLocation(Node);
+
+      // Variables without an initializer start out as zero.
+      if (val == nullptr)
+        val = Int32Zero;
+
+      // The initial value is the first definition of each variable.
+      for (auto I = Node.begin(), E = Node.end(); I != E; ++I)
+        writeVariable(Builder.GetInsertBlock(), *I, val);
+    };
+  };
+}; // namespace
+
+std::unique_ptr<Module> CodeGen::compile(AST *Tree, const TreeFacts &Facts, LLVMContext &Ctx,
+                                         StringRef FileName)
+{
+  // Create a module in the caller's context.
+  auto M = std::make_unique<Module>("calc.expr", Ctx);
+
+  // Create an instance of the ToIRVisitor and run it on the AST to generate LLVM IR.
+  MapVector<StringRef, unsigned> FrameSlots;
+  ToIRVisitor ToIR(M.get(), FileName, Facts, FrameSlots, LineInfo);
+  ToIR.run(Tree);
+
+  return M;
+}
+
+std::unique_ptr<Module> CodeGen::compileChunk(AST *Tree, const TreeFacts &Facts, LLVMContext &Ctx,
+                                              StringRef FileName)
+{
+  // The counters of a profile belong to the whole program.
+  if (!ProfileGenerate.empty() || !ProfileUse.empty())
+  {
+    errs() << "Profiles are not supported for programs compiled in chunks\n";
+    return nullptr;
+  }
+
+  auto M = std::make_unique<Module>("calc.expr.chunk." + std::to_string(NumChunks), Ctx);
+  ToIRVisitor ToIR(M.get(), FileName, Facts, FrameSlots, LineInfo);
+  ToIR.runChunk(Tree, NumChunks++);
+  return M;
+}
+
+std::unique_ptr<Module> CodeGen::compileMain(LLVMContext &Ctx, StringRef FileName)
+{
+  // main generates no statements, so there are no facts about them.
+  auto M = std::make_unique<Module>("calc.expr", Ctx);
+  TreeFacts None;
+  ToIRVisitor ToIR(M.get(), FileName, None, FrameSlots, LineInfo);
+  ToIR.runStreamMain(NumChunks);
+  return M;
+}
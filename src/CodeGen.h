@@ -1,12 +1,45 @@
-#ifndef CODEGEN_H
-#define CODEGEN_H
-
-#include "AST.h"
-
-class CodeGen
-{
-public:
- void compile(AST *Tree);
-
-};
-#endif
\ No newline at end of file
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include "AST.h"
+#include "Analysis.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include <memory>
+
+class CodeGen
+{
+ // State of a program compiled in chunks: the frame slot of every variable
+ // and the number of chunks so far. The slots refer to the source text.
+ llvm::MapVector<llvm::StringRef, unsigned> FrameSlots;
+ unsigned NumChunks = 0;
+ bool LineInfo = false;
+
+public:
+ // Attributes the code of every statement to its line and column in a DWARF
+ // line table, as -g does without the rest of the debug information, and
+ // compiles programs that could be evaluated in the compiler as they are.
+ // Tools use it to map the machine code back to the statements.
+ void setLineInfo(bool On) { LineInfo = On; }
+
+ // Generates the LLVM module for the tree in the given context, with the
+ // facts the semantic checks collected about it (see Sema::getFacts). The
+ // file name is used for the debug information.
+ std::unique_ptr<llvm::Module> compile(AST *Tree, const TreeFacts &Facts,
+                                       llvm::LLVMContext &Ctx, llvm::StringRef FileName);
+
+ // Generates the next chunk of top-level statements of a program as a module
+ // of its own, whose function gsm.chunk.<N> runs them on the frame of the
+ // program. Chunks are generated in program order, and their trees and
+ // modules may be freed once generated. Returns nullptr if the options do
+ // not allow chunks.
+ std::unique_ptr<llvm::Module> compileChunk(AST *Tree, const TreeFacts &Facts,
+                                            llvm::LLVMContext &Ctx, llvm::StringRef FileName);
+
+ // Generates the module with the main of a program compiled in chunks,
+ // which allocates the frame and calls the chunks in order.
+ std::unique_ptr<llvm::Module> compileMain(llvm::LLVMContext &Ctx, llvm::StringRef FileName);
+
+};
+#endif
@@ -0,0 +1,299 @@
+#include "CostReport.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCDisassembler/MCDisassembler.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstrAnalysis.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/MCA/Context.h"
+#include "llvm/MCA/CustomBehaviour.h"
+#include "llvm/MCA/HWEventListener.h"
+#include "llvm/MCA/InstrBuilder.h"
+#include "llvm/MCA/Pipeline.h"
+#include "llvm/MCA/SourceMgr.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Object/SymbolSize.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/TargetSelect.h"
+#include <algorithm>
+
+using namespace llvm;
+
+// Option controlling the simulation of the cost report.
+static cl::opt<unsigned>
+    CostIterations("cost-iterations",
+                   cl::desc("Number of times the code of every statement is simulated "
+                            "for --cost-report"),
+                   cl::init(100));
+
+namespace
+{
+  // The machine code attributed to a statement, and what its simulation
+  // gave per iteration.
+  struct Region
+  {
+    std::vector<MCInst> Insts;
+    unsigned Calls = 0;
+    unsigned UOps = 0;
+    double Cycles = 0;
+    SmallVector<double, 16> Pressure;
+  };
+
+  // Adds up the resource cycles of every issued instruction per processor
+  // resource unit, like the resource pressure view of llvm-mca. Units is
+  // the index of the first unit of every processor resource.
+  class PressureListener : public mca::HWEventListener
+  {
+    const DenseMap<uint64_t, unsigned> &Units;
+    SmallVectorImpl<double> &Pressure;
+
+  public:
+    PressureListener(const DenseMap<uint64_t, unsigned> &Units, SmallVectorImpl<double> &Pressure)
+        : Units(Units), Pressure(Pressure) {}
+
+    void onEvent(const mca::HWInstructionEvent &Event) override
+    {
+      if (Event.Type != mca::HWInstructionEvent::Issued)
+        return;
+      const auto &Issued = static_cast<const mca::HWInstructionIssuedEvent &>(Event);
+      for (const mca::ResourceUse &Use : Issued.UsedResources)
+        Pressure[Units.lookup(Use.first.first) + countTrailingZeros(Use.first.second)] +=
+            Use.second;
+    }
+  };
+
+  bool isBefore(SourceLoc A, SourceLoc B)
+  {
+    return A.Line != B.Line ? A.Line < B.Line : A.Col < B.Col;
+  }
+
+  // Returns the source text of a statement for the table, cut at the end of
+  // its line or where the next statement starts.
+  std::string getStatementText(ArrayRef<StringRef> Lines, SourceLoc Loc, SourceLoc Next)
+  {
+    if (!Loc.Line || Loc.Line > Lines.size())
+      return "";
+    StringRef Text = Lines[Loc.Line - 1];
+    if (Next.Line == Loc.Line)
+      Text = Text.take_front(Next.Col - 1);
+    Text = Text.drop_front(Loc.Col - 1).trim();
+    if (Text.size() <= 40)
+      return Text.str();
+    return Text.take_front(37).str() + "...";
+  }
+}
+
+void CostReport::addStatements(AST *Tree)
+{
+  for (Expr *E : *static_cast<GSM *>(Tree))
+    Starts.push_back(E->getLoc());
+}
+
+bool CostReport::print(StringRef Object, TargetMachine &TM, StringRef Source, raw_ostream &OS)
+{
+  InitializeNativeTargetDisassembler();
+
+  const MCSubtargetInfo &STI = *TM.getMCSubtargetInfo();
+  const MCRegisterInfo &MRI = *TM.getMCRegisterInfo();
+  const MCInstrInfo &MCII = *TM.getMCInstrInfo();
+  const MCSchedModel &SM = STI.getSchedModel();
+  if (!SM.hasInstrSchedModel())
+  {
+    errs() << "The CPU " << TM.getTargetCPU()
+           << " has no scheduling model, pick one with -mcpu for --cost-report\n";
+    return false;
+  }
+
+  Expected<std::unique_ptr<object::ObjectFile>> Obj =
+      object::ObjectFile::createObjectFile(MemoryBufferRef(Object, "calc.expr"));
+  if (!Obj)
+  {
+    logAllUnhandledErrors(Obj.takeError(), errs(), "Cost report: ");
+    return false;
+  }
+  std::unique_ptr<DIContext> Lines = DWARFContext::create(**Obj);
+
+  MCContext Ctx(TM.getTargetTriple(), TM.getMCAsmInfo(), &MRI, &STI);
+  std::unique_ptr<MCDisassembler> Dis(TM.getTarget().createMCDisassembler(STI, Ctx));
+  if (!Dis)
+  {
+    errs() << "No disassembler for " << TM.getTargetTriple().str() << "\n";
+    return false;
+  }
+
+  // Split the code of every function into the regions of the statements
+  // along the line table. The last region collects the code of no
+  // statement: the entry and exit of functions, code the optimizer could
+  // not attribute to a single statement and the helpers of the runtime.
+  std::vector<Region> Regions(Starts.size() + 1);
+  Region &Outside = Regions.back();
+  for (const auto &SymSize : object::computeSymbolSizes(**Obj))
+  {
+    const object::SymbolRef &Sym = SymSize.first;
+    Expected<object::SymbolRef::Type> Type = Sym.getType();
+    Expected<uint64_t> Addr = Sym.getAddress();
+    Expected<object::section_iterator> Sec = Sym.getSection();
+    if (!Type || !Addr || !Sec || *Type != object::SymbolRef::ST_Function ||
+        *Sec == (*Obj)->section_end())
+    {
+      consumeError(Type.takeError());
+      consumeError(Addr.takeError());
+      consumeError(Sec.takeError());
+      continue;
+    }
+    Expected<StringRef> Contents = (*Sec)->getContents();
+    if (!Contents)
+    {
+      consumeError(Contents.takeError());
+      continue;
+    }
+    ArrayRef<uint8_t> Bytes(reinterpret_cast<const uint8_t *>(Contents->data()), Contents->size());
+    uint64_t SecAddr = (*Sec)->getAddress();
+    uint64_t End = std::min<uint64_t>(*Addr - SecAddr + SymSize.second, Bytes.size());
+
+    for (uint64_t Offset = *Addr - SecAddr, Size; Offset < End; Offset += Size)
+    {
+      MCInst Inst;
+      if (Dis->getInstruction(Inst, Size, Bytes.slice(Offset, End - Offset), SecAddr + Offset,
+                              nulls()) != MCDisassembler::Success)
+      {
+        Size = std::max<uint64_t>(Size, 1);
+        continue;
+      }
+
+      // Column 0 marks the entry of a function, line 0 code of no line.
+      DILineInfo Line = Lines->getLineInfoForAddress({SecAddr + Offset, (*Sec)->getIndex()});
+      Region *R = &Outside;
+      if (Line.Line && Line.Column)
+      {
+        auto It = std::upper_bound(Starts.begin(), Starts.end(),
+                                   SourceLoc{Line.Line, Line.Column}, isBefore);
+        if (It != Starts.begin())
+          R = &Regions[It - Starts.begin() - 1];
+      }
+
+      // The scheduling model knows nothing about the callee, and the end of
+      // a function is not part of the simulated sequence.
+      const MCInstrDesc &Desc = MCII.get(Inst.getOpcode());
+      if (Desc.isCall())
+        ++R->Calls;
+      else if (!Desc.isReturn())
+        R->Insts.push_back(Inst);
+    }
+  }
+
+  // Number the units of the processor resources. Groups of resources are
+  // charged to their units.
+  DenseMap<uint64_t, unsigned> Units;
+  SmallVector<std::string, 16> UnitNames;
+  for (unsigned I = 1, E = SM.getNumProcResourceKinds(); I < E; ++I)
+  {
+    const MCProcResourceDesc &Res = *SM.getProcResource(I);
+    if (Res.SubUnitsIdxBegin || !Res.NumUnits)
+      continue;
+    Units[I] = UnitNames.size();
+    for (unsigned U = 0; U != Res.NumUnits; ++U)
+      UnitNames.push_back(Res.NumUnits == 1 ? std::string(Res.Name)
+                                            : std::string(Res.Name) + "." + std::to_string(U));
+  }
+
+  // Simulate every region on its own, as llvm-mca would a basic block.
+  std::unique_ptr<MCInstrAnalysis> MCIA(TM.getTarget().createMCInstrAnalysis(&MCII));
+  mca::Context MCA(MRI, STI);
+  mca::InstrBuilder IB(STI, MCII, MRI, MCIA.get());
+  mca::PipelineOptions Options(0, 0, 0, 0, 0, 0, /*NoAlias=*/true);
+  unsigned Iterations = std::max(1u, unsigned(CostIterations));
+  unsigned Unmodeled = 0;
+  for (Region &R : Regions)
+  {
+    R.Pressure.assign(UnitNames.size(), 0);
+    std::vector<std::unique_ptr<mca::Instruction>> Insts;
+    for (const MCInst &Inst : R.Insts)
+    {
+      Expected<std::unique_ptr<mca::Instruction>> I = IB.createInstruction(Inst);
+      if (!I)
+      {
+        consumeError(I.takeError());
+        ++Unmodeled;
+        continue;
+      }
+      R.UOps += (*I)->getDesc().NumMicroOps;
+      Insts.push_back(std::move(*I));
+    }
+    if (Insts.empty())
+      continue;
+
+    mca::SourceMgr Src(Insts, Iterations);
+    mca::CustomBehaviour CB(STI, Src, MCII);
+    std::unique_ptr<mca::Pipeline> P = MCA.createDefaultPipeline(Options, Src, CB);
+    PressureListener Listener(Units, R.Pressure);
+    P->addEventListener(&Listener);
+    Expected<unsigned> Cycles = P->run();
+    if (!Cycles)
+    {
+      logAllUnhandledErrors(Cycles.takeError(), errs(), "Cost report: ");
+      return false;
+    }
+    R.Cycles = double(*Cycles) / Iterations;
+    for (double &P : R.Pressure)
+      P /= Iterations;
+  }
+
+  // One row per statement in source order, then the code outside of them
+  // and the sums.
+  OS << "Estimated cycles and resource pressure per run of each top-level statement on "
+     << TM.getTargetCPU() << " (" << Iterations << " iterations simulated, calls counted "
+     << "but not simulated)\n\nResources:\n";
+  for (unsigned I = 0, E = UnitNames.size(); I != E; ++I)
+    OS << format("[%u] - ", I) << UnitNames[I] << "\n";
+
+  OS << "\nLine:Col   Insts  Calls   uOps   Cycles";
+  for (unsigned I = 0, E = UnitNames.size(); I != E; ++I)
+    OS << " " << right_justify("[" + std::to_string(I) + "]", 6);
+  OS << "  Statement\n";
+
+  SmallVector<StringRef, 64> SourceLines;
+  Source.split(SourceLines, '\n');
+  Region Total;
+  Total.Pressure.assign(UnitNames.size(), 0);
+  auto PrintRow = [&](StringRef Pos, const Region &R, StringRef Text)
+  {
+    OS << format("%-9s %6u %6u %6u %8.2f", Pos.str().c_str(), unsigned(R.Insts.size()), R.Calls,
+                 R.UOps, R.Cycles);
+    for (double P : R.Pressure)
+    {
+      if (P)
+        OS << format(" %6.2f", P);
+      else
+        OS << "      -";
+    }
+    if (!Text.empty())
+      OS << "  " << Text;
+    OS << "\n";
+  };
+  for (unsigned I = 0, E = Regions.size(); I != E; ++I)
+  {
+    Region &R = Regions[I];
+    if (I + 1 == E)
+      PrintRow("-", R, "(outside statements)");
+    else
+      PrintRow(std::to_string(Starts[I].Line) + ":" + std::to_string(Starts[I].Col), R,
+               getStatementText(SourceLines, Starts[I],
+                                I + 2 < E ? Starts[I + 1] : SourceLoc()));
+    Total.Insts.insert(Total.Insts.end(), R.Insts.begin(), R.Insts.end());
+    Total.Calls += R.Calls;
+    Total.UOps += R.UOps;
+    Total.Cycles += R.Cycles;
+    for (unsigned U = 0, N = R.Pressure.size(); U != N; ++U)
+      Total.Pressure[U] += R.Pressure[U];
+  }
+  PrintRow("Total", Total, "");
+
+  if (Unmodeled)
+    OS << "\n" << Unmodeled << " instructions could not be modeled and were left out\n";
+  return true;
+}
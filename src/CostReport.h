@@ -0,0 +1,33 @@
+#ifndef COSTREPORT_H
+#define COSTREPORT_H
+
+#include "AST.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+
+// CostReport estimates what every top-level statement of a program costs,
+// without running it. The object code of the program is disassembled and
+// split into one region per statement along its DWARF line table, and each
+// region is simulated with the scheduling model of the target CPU by the
+// machinery of llvm-mca, which gives its cycles and the pressure on every
+// execution port. Calls leave the region and are counted instead.
+class CostReport
+{
+  llvm::SmallVector<SourceLoc, 16> Starts; // where each top-level statement starts
+
+public:
+  // Records the top-level statements of the program. The module must be
+  // generated with line information, see CodeGen::setLineInfo.
+  void addStatements(AST *Tree);
+
+  // Prints the table of the regions of the object code, one row per
+  // statement with its source text and one row for the code outside all
+  // statements. Returns false and reports the problem if the target cannot
+  // be modeled.
+  bool print(llvm::StringRef Object, llvm::TargetMachine &TM, llvm::StringRef Source,
+             llvm::raw_ostream &OS);
+};
+
+#endif
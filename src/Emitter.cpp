@@ -0,0 +1,169 @@
+#include "Emitter.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+std::unique_ptr<Emitter> Emitter::create(int OptLevel, StringRef CPU)
+{
+  InitializeNativeTarget();
+  InitializeNativeTargetAsmPrinter();
+
+  // Look up the target for the host triple.
+  std::string Triple = sys::getDefaultTargetTriple();
+  std::string Error;
+  const Target *T = TargetRegistry::lookupTarget(Triple, Error);
+  if (!T)
+  {
+    errs() << Error << "\n";
+    return nullptr;
+  }
+
+  CodeGenOpt::Level CGLevel = getCodeGenLevel(OptLevel);
+
+  // Ask the host for its CPU and the features that the CPU and the OS
+  // support.
+  std::string CPUName = CPU.str();
+  SubtargetFeatures Features;
+  if (CPU == "native")
+  {
+    CPUName = sys::getHostCPUName().str();
+    StringMap<bool> HostFeatures;
+    if (sys::getHostCPUFeatures(HostFeatures))
+    {
+      for (auto &F : HostFeatures)
+        Features.AddFeature(F.first(), F.second);
+    }
+  }
+
+  TargetOptions Options;
+  std::unique_ptr<TargetMachine> TM(T->createTargetMachine(
+      Triple, CPUName, Features.getString(), Options, Optional<Reloc::Model>(Reloc::PIC_),
+      None, CGLevel));
+  if (!TM)
+  {
+    errs() << "Could not create target machine for " << Triple << "\n";
+    return nullptr;
+  }
+  return std::unique_ptr<Emitter>(new Emitter(std::move(TM)));
+}
+
+std::unique_ptr<Emitter> Emitter::clone() const
+{
+  std::unique_ptr<TargetMachine> Copy(TM->getTarget().createTargetMachine(
+      TM->getTargetTriple().getTriple(), TM->getTargetCPU(), TM->getTargetFeatureString(),
+      TM->Options, TM->getRelocationModel(), TM->getCodeModel(), TM->getOptLevel()));
+  if (!Copy)
+  {
+    errs() << "Could not create target machine for " << TM->getTargetTriple().getTriple() << "\n";
+    return nullptr;
+  }
+  return std::unique_ptr<Emitter>(new Emitter(std::move(Copy)));
+}
+
+CodeGenOpt::Level Emitter::getCodeGenLevel(int OptLevel)
+{
+  if (OptLevel == 0)
+    return CodeGenOpt::None;
+  if (OptLevel == 1)
+    return CodeGenOpt::Less;
+  if (OptLevel == 3)
+    return CodeGenOpt::Aggressive;
+  return CodeGenOpt::Default;
+}
+
+void Emitter::configure(Module &M)
+{
+  M.setTargetTriple(TM->getTargetTriple().getTriple());
+  M.setDataLayout(TM->createDataLayout());
+
+  // Code generation and the cost models of the optimizer read the CPU from
+  // the function attributes.
+  StringRef CPU = TM->getTargetCPU();
+  StringRef Features = TM->getTargetFeatureString();
+  for (Function &F : M)
+  {
+    if (F.isDeclaration())
+      continue;
+    F.addFnAttr("target-cpu", CPU);
+    if (!Features.empty())
+      F.addFnAttr("target-features", Features);
+  }
+}
+
+bool Emitter::emitObject(Module &M, raw_pwrite_stream &OS)
+{
+  // Code generation still uses the legacy pass manager.
+  legacy::PassManager PM;
+  if (TM->addPassesToEmitFile(PM, OS, nullptr, CGFT_ObjectFile))
+  {
+    errs() << "No support for object file emission\n";
+    return false;
+  }
+  PM.run(M);
+  return true;
+}
+
+void Emitter::emitBitcode(ArrayRef<std::unique_ptr<Module>> Modules,
+                          raw_ostream &OS)
+{
+  if (Modules.size() == 1)
+    WriteBitcodeToFile(*Modules.front(), OS);
+  else
+  {
+    // All modules share one string table and symbol table, so a reader can
+    // list the modules and symbols without parsing any module body.
+    SmallVector<char, 0> Buffer;
+    BitcodeWriter Writer(Buffer);
+    for (const auto &M : Modules)
+      Writer.writeModule(*M);
+    Writer.writeSymtab();
+    Writer.writeStrtab();
+    OS.write(Buffer.data(), Buffer.size());
+  }
+}
+
+bool Emitter::link(StringRef Object, StringRef Runtime, StringRef Output)
+{
+  auto CC = sys::findProgramByName("cc");
+  if (!CC)
+  {
+    errs() << "No system compiler driver found to link with\n";
+    return false;
+  }
+
+  StringRef Args[] = {*CC, Object, Runtime, "-pthread", "-o", Output};
+  std::string ErrMsg;
+  if (sys::ExecuteAndWait(*CC, Args, None, {}, 0, 0, &ErrMsg) != 0)
+  {
+    errs() << "Linking failed" << (ErrMsg.empty() ? "" : ": ") << ErrMsg << "\n";
+    return false;
+  }
+  return true;
+}
+
+bool Emitter::linkRelocatable(ArrayRef<std::string> Objects, StringRef Output)
+{
+  auto CC = sys::findProgramByName("cc");
+  if (!CC)
+  {
+    errs() << "No system compiler driver found to link with\n";
+    return false;
+  }
+
+  SmallVector<StringRef, 16> Args = {*CC, "-r", "-nostdlib", "-o", Output};
+  Args.append(Objects.begin(), Objects.end());
+  std::string ErrMsg;
+  if (sys::ExecuteAndWait(*CC, Args, None, {}, 0, 0, &ErrMsg) != 0)
+  {
+    errs() << "Linking failed" << (ErrMsg.empty() ? "" : ": ") << ErrMsg << "\n";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,62 @@
+#ifndef EMITTER_H
+#define EMITTER_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include <memory>
+
+// Emitter lowers a module to native code for the host target.
+class Emitter
+{
+  std::unique_ptr<llvm::TargetMachine> TM;
+
+  Emitter(std::unique_ptr<llvm::TargetMachine> TM) : TM(std::move(TM)) {}
+
+public:
+  // Creates an emitter for the host target, generating code at the given
+  // optimization level for the CPU. "native" selects the CPU and the
+  // features of the host. Returns nullptr if the target is not available.
+  static std::unique_ptr<Emitter> create(int OptLevel,
+                                         llvm::StringRef CPU = "generic");
+
+  // Returns the code generation level of an optimization level: -O0 selects
+  // the fast instruction selector and register allocator, -Os and -Oz
+  // generate code like -O2.
+  static llvm::CodeGenOpt::Level getCodeGenLevel(int OptLevel);
+
+  // Creates an emitter with a target machine of its own for the same target,
+  // CPU, features and level, for use on another thread.
+  std::unique_ptr<Emitter> clone() const;
+
+  llvm::TargetMachine *getTargetMachine() { return TM.get(); }
+
+  // Sets the target triple and data layout of the module, and the CPU and
+  // its features on every function. This must happen before the module is
+  // optimized.
+  void configure(llvm::Module &M);
+
+  // Writes the native object code of the module to the stream.
+  bool emitObject(llvm::Module &M, llvm::raw_pwrite_stream &OS);
+
+  // Writes the modules as bitcode to the stream. More than one module gives
+  // a multi-module file with a symbol table, whose modules can be loaded
+  // lazily and one at a time.
+  static void emitBitcode(llvm::ArrayRef<std::unique_ptr<llvm::Module>> Modules,
+                          llvm::raw_ostream &OS);
+
+  // Links the object file with the runtime library into an executable.
+  // This is not done in-process: it runs the system compiler driver cc,
+  // which runs the system linker.
+  static bool link(llvm::StringRef Object, llvm::StringRef Runtime,
+                   llvm::StringRef Output);
+
+  // Combines object files into one relocatable object file, running the
+  // system compiler driver cc with -r.
+  static bool linkRelocatable(llvm::ArrayRef<std::string> Objects,
+                              llvm::StringRef Output);
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "Evaluator.h"
+#include "llvm/Support/MathExtras.h"
+
+bool Evaluator::run(AST *Tree)
+{
+  if (!Tree)
+    return false;
+  Tree->accept(*this);
+  return !Failed;
+}
+
+bool Evaluator::step()
+{
+  if (Failed || StepsLeft == 0)
+  {
+    Failed = true;
+    return false;
+  }
+  --StepsLeft;
+  return true;
+}
+
+bool Evaluator::eval(Expr *E)
+{
+  if (Failed || !E)
+  {
+    Failed = true;
+    return false;
+  }
+  E->accept(*this);
+  return !Failed;
+}
+
+// Addition, subtraction and multiplication are generated with the nsw flag,
+// and division by zero or of INT_MIN by -1 is undefined, so the program is
+// left to the generated code if they overflow. Powers wrap around.
+bool Evaluator::calculate(BinaryOp_Calculators::Operator Op, int32_t Left, int32_t Right)
+{
+  int32_t Result = 0;
+  bool Overflow = false;
+  switch (Op)
+  {
+  case BinaryOp_Calculators::Plus:
+    Overflow = llvm::AddOverflow(Left, Right, Result);
+    break;
+  case BinaryOp_Calculators::Minus:
+    Overflow = llvm::SubOverflow(Left, Right, Result);
+    break;
+  case BinaryOp_Calculators::Mul:
+    Overflow = llvm::MulOverflow(Left, Right, Result);
+    break;
+  case BinaryOp_Calculators::Div:
+  case BinaryOp_Calculators::Percent:
+    Overflow = Right == 0 || (Left == INT32_MIN && Right == -1);
+    if (!Overflow)
+      Result = Op == BinaryOp_Calculators::Div ? Left / Right : Left % Right;
+    break;
+  case BinaryOp_Calculators::Power:
+  {
+    // Square-and-multiply like gsm.pow; exponents below 1 give 1.
+    uint32_t R = 1, Square = static_cast<uint32_t>(Left);
+    for (uint32_t E = Right > 0 ? Right : 0; E; E >>= 1)
+    {
+      if (E & 1)
+        R *= Square;
+      Square *= Square;
+    }
+    Result = static_cast<int32_t>(R);
+    break;
+  }
+  }
+  if (Overflow)
+  {
+    Failed = true;
+    return false;
+  }
+  V = Result;
+  return true;
+}
+
+void Evaluator::visit(GSM &Node)
+{
+  for (Expr *E : Node)
+  {
+    if (!eval(E))
+      return;
+  }
+}
+
+void Evaluator::visit(Factor &Node)
+{
+  if (!step())
+    return;
+  if (Node.getKind() == Factor::Ident)
+  {
+    V = Vars.lookup(Node.getVal());
+    return;
+  }
+  int Val;
+  if (Node.getVal().getAsInteger(10, Val))
+  {
+    Failed = true;
+    return;
+  }
+  V = Val;
+}
+
+void Evaluator::visit(BinaryOp_Calculators &Node)
+{
+  if (!step() || !eval(Node.getLeft()))
+    return;
+  int32_t Left = V;
+  if (!eval(Node.getRight()))
+    return;
+  calculate(Node.getOperator(), Left, V);
+}
+
+void Evaluator::visit(BinaryOp_Relational &Node)
+{
+  if (!step() || !eval(Node.getLeft()))
+    return;
+  int32_t Left = V;
+  if (!eval(Node.getRight()))
+    return;
+  int32_t Right = V;
+
+  switch (Node.getOperator())
+  {
+  case BinaryOp_Relational::Equality:
+    V = Left == Right;
+    break;
+  case BinaryOp_Relational::Not_equal:
+    V = Left != Right;
+    break;
+  case BinaryOp_Relational::Greater_than_or_equal:
+    V = Left >= Right;
+    break;
+  case BinaryOp_Relational::Less_than_or_equal:
+    V = Left <= Right;
+    break;
+  case BinaryOp_Relational::Greater_than:
+    V = Left > Right;
+    break;
+  case BinaryOp_Relational::Less_than:
+    V = Left < Right;
+    break;
+  }
+}
+
+// The right-hand side is only evaluated if the left one does not decide the
+// result.
+void Evaluator::visit(BinaryOp_Logical &Node)
+{
+  if (!step() || !eval(Node.getLeft()))
+    return;
+  bool IsAnd = Node.getOperator() == BinaryOp_Logical::KW_AND;
+  if ((V != 0) != IsAnd)
+  {
+    V = !IsAnd;
+    return;
+  }
+  if (!eval(Node.getRight()))
+    return;
+  V = V != 0;
+}
+
+void Evaluator::visit(BinaryOp_Attribution &Node)
+{
+  if (!step() || !eval(Node.getLeft()))
+    return;
+  int32_t Left = V;
+  if (!eval(Node.getRight()))
+    return;
+
+  BinaryOp_Calculators::Operator Op = BinaryOp_Calculators::Plus;
+  switch (Node.getOperator())
+  {
+  case BinaryOp_Attribution::Plus_equal:
+    Op = BinaryOp_Calculators::Plus;
+    break;
+  case BinaryOp_Attribution::Minus_equal:
+    Op = BinaryOp_Calculators::Minus;
+    break;
+  case BinaryOp_Attribution::Slash_equal:
+    Op = BinaryOp_Calculators::Div;
+    break;
+  case BinaryOp_Attribution::Star_equal:
+    Op = BinaryOp_Calculators::Mul;
+    break;
+  }
+  if (!calculate(Op, Left, V))
+    return;
+
+  // Assign the result back to the variable on the left.
+  if (auto *F = dyn_cast<Factor>(Node.getLeft()))
+  {
+    if (F->getKind() == Factor::Ident)
+      Vars[F->getVal()] = V;
+  }
+}
+
+void Evaluator::visit(Assignment &Node)
+{
+  if (!step() || !eval(Node.getRight()))
+    return;
+  Vars[Node.getLeft()->getVal()] = V;
+
+  // The same text as gsm_write, one line per assignment.
+  Output += std::to_string(V);
+  Output += '\n';
+  if (Output.size() > MaxOutput)
+    Failed = true;
+}
+
+void Evaluator::visit(Declaration &Node)
+{
+  if (!step())
+    return;
+
+  // Variables without an initializer start out as zero.
+  V = 0;
+  if (Node.getExpr() && !eval(Node.getExpr()))
+    return;
+  for (llvm::StringRef Var : Node)
+    Vars[Var] = V;
+}
+
+// The first arm whose condition holds runs, or the else arm if none does.
+void Evaluator::visit(Condition &Node)
+{
+  if (!step())
+    return;
+  for (Condition::Arm &A : Node)
+  {
+    if (A.Cond)
+    {
+      if (!eval(A.Cond))
+        return;
+      if (!V)
+        continue;
+    }
+    for (Expr *S : A.Body)
+    {
+      if (!eval(S))
+        return;
+    }
+    return;
+  }
+}
+
+void Evaluator::visit(Loop &Node)
+{
+  while (step() && eval(Node.getCond()) && V)
+  {
+    for (Expr *S : Node)
+    {
+      if (!eval(S))
+        return;
+    }
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include "AST.h"
+#include "llvm/ADT/StringMap.h"
+#include <cstdint>
+#include <string>
+
+// Evaluator runs a program in the compiler. GSM programs read no input, so a
+// program that finishes within the budgets always writes the same output,
+// which the generated code can write as a constant. The evaluation gives up
+// if a budget runs out or if the program has undefined behavior, which the
+// generated code may treat differently.
+class Evaluator : public ASTVisitor
+{
+  llvm::StringMap<int32_t> Vars; // Current value of every variable
+  std::string Output;            // Text written so far
+  int32_t V = 0;                 // Value of the last expression
+  uint64_t StepsLeft;            // Expression nodes that may still be evaluated
+  uint64_t MaxOutput;            // Longest output in bytes
+  bool Failed = false;
+
+  // Charges one step and returns false if the evaluation has to stop.
+  bool step();
+
+  // Evaluates E and returns false if the evaluation has to stop.
+  bool eval(Expr *E);
+
+  // Computes Left Op Right with the semantics of the generated code.
+  bool calculate(BinaryOp_Calculators::Operator Op, int32_t Left, int32_t Right);
+
+public:
+  Evaluator(uint64_t MaxSteps, uint64_t MaxOutput)
+      : StepsLeft(MaxSteps), MaxOutput(MaxOutput) {}
+
+  // Runs the program. Returns false if it could not be evaluated.
+  bool run(AST *Tree);
+
+  // The output of the program, one line per assignment.
+  const std::string &getOutput() { return Output; }
+
+  virtual void visit(GSM &Node) override;
+  virtual void visit(Factor &Node) override;
+  virtual void visit(BinaryOp_Calculators &Node) override;
+  virtual void visit(BinaryOp_Relational &Node) override;
+  virtual void visit(BinaryOp_Logical &Node) override;
+  virtual void visit(BinaryOp_Attribution &Node) override;
+  virtual void visit(Assignment &Node) override;
+  virtual void visit(Declaration &Node) override;
+  virtual void visit(Condition &Node) override;
+  virtual void visit(Loop &Node) override;
+};
+
+#endif
@@ -1,53 +1,689 @@
-#include "CodeGen.h"
-#include "Parser.h"
-#include "Sema.h"
-#include "llvm/Support/CommandLine.h"
-#include "llvm/Support/InitLLVM.h"
-#include "llvm/Support/raw_ostream.h"
-
-// Define a command-line option for specifying the input expression.
-static llvm::cl::opt<std::string>
-    Input(llvm::cl::Positional,
-          llvm::cl::desc("<input expression>"),
-          llvm::cl::init(""));
-
-// The main function of the program.
-int main(int argc, const char **argv)
-{
-    // Initialize the LLVM framework.
-    llvm::InitLLVM X(argc, argv);
-
-    // Parse command-line options.
-    llvm::cl::ParseCommandLineOptions(argc, argv, "GSM - the expression compiler\n");
-
-    // Create a lexer object and initialize it with the input expression.
-    Lexer Lex(Input);
-
-    // Create a parser object and initialize it with the lexer.
-    Parser Parser(Lex);
-
-    // Parse the input expression and generate an abstract syntax tree (AST).
-    AST *Tree = Parser.parse();
-
-    // Check if parsing was successful or if there were any syntax errors.
-    if (!Tree || Parser.hasError())
-    {
-        llvm::errs() << "Syntax errors occurred\n";
-        return 1;
-    }
-
-    // Perform semantic analysis on the AST.
-    Sema Semantic;
-    if (Semantic.semantic(Tree))
-    {
-        llvm::errs() << "Semantic errors occurred\n";
-        return 1;
-    }
-
-    // Generate code for the AST using a code generator.
-    CodeGen CodeGenerator;
-    CodeGenerator.compile(Tree);
-
-    // The program executed successfully.
-    return 0;
-}
+#include "Cache.h"
+#include "CodeGen.h"
+#include "CostReport.h"
+#include "Emitter.h"
+#include "JIT.h"
+#include "Multiversion.h"
+#include "Optimizer.h"
+#include "ParallelCG.h"
+#include "Parser.h"
+#include "Remarks.h"
+#include "Sema.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/StringSaver.h"
+#include "llvm/Support/SystemUtils.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+#include <map>
+
+// Define a command-line option for specifying the input expressions.
+static llvm::cl::list<std::string>
+    Inputs(llvm::cl::Positional,
+           llvm::cl::desc("<input expression>..."),
+           llvm::cl::ZeroOrMore);
+
+static llvm::cl::opt<bool>
+    InputFiles("files",
+               llvm::cl::desc("Read the programs from the files named by the inputs"),
+               llvm::cl::init(false));
+
+// Define the optimization level options, -O0 is the default.
+static llvm::cl::opt<signed char>
+    OptLevel(llvm::cl::desc("Setting the optimization level:"),
+             llvm::cl::ZeroOrMore,
+             llvm::cl::values(
+                 clEnumValN(3, "O", "Equivalent to -O3"),
+                 clEnumValN(0, "O0", "Optimization level 0"),
+                 clEnumValN(1, "O1", "Optimization level 1"),
+                 clEnumValN(2, "O2", "Optimization level 2"),
+                 clEnumValN(3, "O3", "Optimization level 3"),
+                 clEnumValN(-1, "Os", "Like -O2 with extra optimizations for size"),
+                 clEnumValN(-2, "Oz", "Like -Os but reduces code size further")),
+             llvm::cl::init(0));
+
+// Define a command-line option for a custom pass pipeline.
+static llvm::cl::opt<std::string>
+    PassPipeline("passes",
+                 llvm::cl::desc("A textual pass pipeline, overrides -O (e.g. \"mem2reg,instcombine\")"),
+                 llvm::cl::init(""));
+
+// Define a command-line option for the fastest compilation.
+static llvm::cl::opt<bool>
+    FastCompile("fast-compile",
+                llvm::cl::desc("Compile for latency: like -O0, but skip the IR verifier and the "
+                               "-O0 passes, emit no unwind tables and JIT-compile for the small "
+                               "code model, whose calls the fast instruction selector handles "
+                               "(replaces -O and -passes)"),
+                llvm::cl::init(false));
+
+// Define a command-line option to run the program instead of printing it.
+static llvm::cl::opt<bool>
+    Run("run",
+        llvm::cl::desc("Compile the program with the in-process JIT and run it"),
+        llvm::cl::init(false));
+
+// Define command-line options for native code emission.
+static llvm::cl::opt<bool>
+    EmitObject("c",
+               llvm::cl::desc("Write a native object file for the host target"),
+               llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+    Link("link",
+         llvm::cl::desc("Link the object file with the runtime into an executable, "
+                        "running the system compiler driver cc"),
+         llvm::cl::init(false));
+
+static llvm::cl::opt<std::string>
+    Output("o",
+           llvm::cl::desc("Output file name (default a.o with -c, a.out with --link)"),
+           llvm::cl::init(""));
+
+static llvm::cl::opt<std::string>
+    Runtime("runtime",
+            llvm::cl::desc("Runtime library to link executables with"),
+            llvm::cl::init(GSM_RUNTIME));
+
+static llvm::cl::opt<bool>
+    AsyncOutput("async-output",
+                llvm::cl::desc("Link with the runtime that writes output on a background thread"),
+                llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+    InlineRuntime("inline-runtime",
+                  llvm::cl::desc("Link the runtime bitcode into the module so it can be inlined"),
+                  llvm::cl::init(false));
+
+static llvm::cl::opt<std::string>
+    RuntimeBitcode("runtime-bc",
+                   llvm::cl::desc("Runtime library bitcode used by --inline-runtime"),
+                   llvm::cl::init(GSM_RUNTIME_BC));
+
+static llvm::cl::opt<bool>
+    EmitBitcode("emit-bc",
+                llvm::cl::desc("Write the module as bitcode (to stdout unless -o is given)"),
+                llvm::cl::init(false));
+
+// Define command-line options for the target CPU.
+static llvm::cl::opt<std::string>
+    CPU("mcpu",
+        llvm::cl::desc("Generate code for this CPU, \"native\" for the host (default generic)"),
+        llvm::cl::init("generic"));
+
+static llvm::cl::alias
+    Arch("march",
+         llvm::cl::desc("Alias for -mcpu"),
+         llvm::cl::aliasopt(CPU));
+
+static llvm::cl::opt<bool>
+    Multiversioning("multiversion",
+                    llvm::cl::desc("Compile functions with loops for the x86-64 ISA levels "
+                                   "and pick one at startup"),
+                    llvm::cl::init(false));
+
+// Define a command-line option for parallel optimization and code generation.
+static llvm::cl::opt<unsigned>
+    Threads("threads",
+            llvm::cl::desc("Optimize and compile the functions of the program on this many "
+                           "threads, see -split-functions (0 uses all cores)"),
+            llvm::cl::init(1));
+
+// Define a command-line option for compiling huge programs in bounded memory.
+static llvm::cl::opt<unsigned>
+    Stream("stream",
+           llvm::cl::desc("Compile the program in chunks of this many top-level statements, "
+                          "freeing each chunk before the next (needs -c, --link or --run)"),
+           llvm::cl::init(0));
+
+// Define command-line options for the compilation cache.
+static llvm::cl::opt<std::string>
+    CacheDir("cache-dir",
+             llvm::cl::desc("Look up and store compiled outputs in this directory"),
+             llvm::cl::init(""));
+
+static llvm::cl::opt<std::string>
+    CachePolicy("cache-policy",
+                llvm::cl::desc("Eviction policy of the cache directory "
+                               "(e.g. \"cache_size_bytes=1g:prune_after=168h\")"),
+                llvm::cl::init("cache_size_bytes=1g:prune_after=168h"));
+
+// Define command-line options for optimization remarks.
+static llvm::cl::opt<std::string>
+    RemarksPassed("Rpass",
+                  llvm::cl::desc("Print the optimizations done by the passes matching the regex"),
+                  llvm::cl::value_desc("regex"),
+                  llvm::cl::init(""));
+
+static llvm::cl::opt<std::string>
+    RemarksMissed("Rpass-missed",
+                  llvm::cl::desc("Print the optimizations missed by the passes matching the regex"),
+                  llvm::cl::value_desc("regex"),
+                  llvm::cl::init(""));
+
+static llvm::cl::opt<std::string>
+    RemarksAnalysis("Rpass-analysis",
+                    llvm::cl::desc("Print the analysis results of the passes matching the regex"),
+                    llvm::cl::value_desc("regex"),
+                    llvm::cl::init(""));
+
+static llvm::cl::opt<bool>
+    SaveOptRecord("fsave-optimization-record",
+                  llvm::cl::desc("Save all optimization remarks as YAML (to <output>.opt.yaml "
+                                 "or gsm.opt.yaml)"),
+                  llvm::cl::init(false));
+
+static llvm::cl::opt<std::string>
+    OptRecordFile("foptimization-record-file",
+                  llvm::cl::desc("File name of the optimization record, implies "
+                                 "-fsave-optimization-record"),
+                  llvm::cl::init(""));
+
+// Define a command-line option for estimating the cost of the statements.
+static llvm::cl::opt<bool>
+    CostReportMode("cost-report",
+                   llvm::cl::desc("Print the estimated cycles and port pressure of every "
+                                  "top-level statement on the target CPU instead of the output"),
+                   llvm::cl::init(false));
+
+// Computes the cache key of the invocation. The key covers the inputs, all
+// flags except those that only name outputs or select the link-time runtime
+// or cache, and the contents of the files the compiler reads: the runtime
+// bitcode if it is linked into the module, and the profile. The names of
+// input files are part of the debug information. A value given as the next
+// argument is attached to its flag, so "-fuel 5" and "-fuel=5" are the same
+// flag and "-fuel 5" differs from "-fuel 0".
+static std::string getCacheKey(int argc, const char **argv,
+                               llvm::ArrayRef<std::string> Names)
+{
+    llvm::StringMap<llvm::cl::Option *> &Registered = llvm::cl::getRegisteredOptions();
+    llvm::BumpPtrAllocator Alloc;
+    llvm::StringSaver Saver(Alloc);
+    llvm::SmallVector<llvm::StringRef, 16> Options;
+    llvm::SmallVector<std::string, 2> Files;
+    for (int I = 1; I < argc; ++I)
+    {
+        llvm::StringRef Arg(argv[I]);
+        if (!Arg.startswith("-"))
+            continue;
+        llvm::StringRef Name = Arg.ltrim('-').split('=').first;
+        llvm::cl::Option *Opt = Registered.lookup(Name);
+        if (!Arg.contains('=') && Opt &&
+            Opt->getValueExpectedFlag() == llvm::cl::ValueRequired && I + 1 < argc)
+            Arg = Saver.save(Arg + "=" + argv[++I]);
+        if (Name == "o" || Name == "runtime" || Name == "cache-dir" ||
+            Name == "cache-policy")
+            continue;
+        if (Name == "profile-use")
+            Files.push_back(Arg.split('=').second.str());
+        Options.push_back(Arg);
+    }
+
+    // The output for the host CPU depends on the machine it runs on.
+    std::string HostCPU;
+    if (CPU == "native")
+    {
+        HostCPU = llvm::sys::getHostCPUName().str();
+        llvm::StringMap<bool> Features;
+        if (llvm::sys::getHostCPUFeatures(Features))
+        {
+            std::map<std::string, bool> Sorted;
+            for (auto &F : Features)
+                Sorted[F.first().str()] = F.second;
+            for (auto &F : Sorted)
+                HostCPU += (F.second ? ",+" : ",-") + F.first;
+        }
+        Options.push_back(HostCPU);
+    }
+
+    if (InlineRuntime)
+        Files.push_back(RuntimeBitcode);
+    llvm::SmallVector<std::unique_ptr<llvm::MemoryBuffer>, 2> Contents;
+    for (const std::string &File : Files)
+    {
+        auto BufOrErr = llvm::MemoryBuffer::getFile(File);
+        if (!BufOrErr)
+        {
+            Options.push_back(File);
+            continue;
+        }
+        Contents.push_back(std::move(*BufOrErr));
+        Options.push_back(Contents.back()->getBuffer());
+    }
+    for (const std::string &Name : Names)
+        Options.push_back(Name);
+    return Cache::computeKey(Inputs, Options);
+}
+
+// Writes the data to the file, or to stdout for "-".
+static bool writeOutput(llvm::StringRef Filename, llvm::StringRef Data, bool Bitcode)
+{
+    std::error_code EC;
+    llvm::ToolOutputFile Out(Filename, EC, llvm::sys::fs::OF_None);
+    if (EC)
+    {
+        llvm::errs() << EC.message() << "\n";
+        return false;
+    }
+
+    // Do not dump binary data on a terminal.
+    if (Bitcode && llvm::CheckBitcodeOutputToConsole(Out.os()))
+        return false;
+
+    Out.os() << Data;
+    Out.keep();
+    return true;
+}
+
+// Delivers the compiled output, either fresh or from the cache: prints the
+// IR, writes the bitcode or object file, links the object or runs it.
+static int deliver(std::unique_ptr<llvm::MemoryBuffer> Artifact, const char *ProgName)
+{
+    llvm::StringRef Data = Artifact->getBuffer();
+    if (EmitBitcode)
+        return writeOutput(Output.empty() ? "-" : Output.getValue(), Data, true) ? 0 : 1;
+
+    if (Run)
+    {
+        JIT Jit(Emitter::getCodeGenLevel(OptLevel), FastCompile);
+        return Jit.runObject(std::move(Artifact), ProgName);
+    }
+
+    if (EmitObject && !Link)
+        return writeOutput(Output.empty() ? "a.o" : Output.getValue(), Data, false) ? 0 : 1;
+    // The system linker reads the object from a file, so it goes through a
+    // temporary one.
+    if (Link)
+    {
+        llvm::SmallString<128> Object;
+        if (llvm::sys::fs::createTemporaryFile("gsm", "o", Object))
+        {
+            llvm::errs() << "Could not create temporary object file\n";
+            return 1;
+        }
+        bool Ok = writeOutput(Object, Data, false) &&
+                  Emitter::link(Object, Runtime, Output.empty() ? "a.out" : Output.getValue());
+        llvm::sys::fs::remove(Object);
+        return Ok ? 0 : 1;
+    }
+
+    llvm::outs() << Data;
+    return 0;
+}
+
+// Compiles one input expression to an optimized module. Returns nullptr if
+// the input has errors. A cost report gets the top-level statements of the
+// program.
+static std::unique_ptr<llvm::Module> compileInput(const std::string &Input,
+                                                  llvm::StringRef Name,
+                                                  llvm::LLVMContext &Ctx,
+                                                  Emitter *Emit,
+                                                  CostReport *Report = nullptr)
+{
+    // Create a lexer object and initialize it with the input expression.
+    Lexer Lex(Input);
+
+    // Create a parser object and initialize it with the lexer.
+    Parser Parser(Lex);
+
+    // Parse the input expression and generate an abstract syntax tree (AST).
+    AST *Tree = Parser.parse();
+
+    // Check if parsing was successful or if there were any syntax errors.
+    if (!Tree || Parser.hasError())
+    {
+        llvm::errs() << "Syntax errors occurred\n";
+        return nullptr;
+    }
+
+    // Perform semantic analysis on the AST.
+    Sema Semantic;
+    if (Semantic.semantic(Tree))
+    {
+        llvm::errs() << "Semantic errors occurred\n";
+        return nullptr;
+    }
+
+    // Generate code for the AST using a code generator. The cost report
+    // maps the machine code back to the statements along the line table.
+    CodeGen CodeGenerator;
+    if (Report)
+    {
+        Report->addStatements(Tree);
+        CodeGenerator.setLineInfo(true);
+    }
+    std::unique_ptr<llvm::Module> M = CodeGenerator.compile(Tree, Semantic.getFacts(), Ctx, Name);
+
+    // Native code needs the target set before the module is optimized.
+    if (Emit)
+        Emit->configure(*M);
+
+    // Clone the functions with loops for the ISA levels of the target.
+    if (Multiversioning)
+    {
+        Multiversion MV;
+        if (!MV.run(*M))
+            return nullptr;
+    }
+
+    // Verify and optimize the module in-process. With several threads, the
+    // module is only prepared here and optimized in partitions later.
+    Optimizer Opt(OptLevel, PassPipeline, Emit ? Emit->getTargetMachine() : nullptr);
+    Opt.setFast(FastCompile);
+    if (InlineRuntime)
+        Opt.setRuntime(RuntimeBitcode);
+    if (Threads != 1 ? !Opt.prepare(*M) : !Opt.run(*M))
+        return nullptr;
+    return M;
+}
+
+// Optimizes the module and compiles it to a new temporary object file, whose
+// name is added to the list.
+static bool emitTemporary(llvm::Module &M, Emitter &Emit,
+                          llvm::SmallVectorImpl<std::string> &Objects)
+{
+    Emit.configure(M);
+    Optimizer Opt(OptLevel, PassPipeline, Emit.getTargetMachine());
+    Opt.setFast(FastCompile);
+    if (!Opt.run(M))
+        return false;
+
+    llvm::SmallString<128> Path;
+    int FD;
+    if (llvm::sys::fs::createTemporaryFile("gsm-chunk", "o", FD, Path))
+    {
+        llvm::errs() << "Could not create temporary object file\n";
+        return false;
+    }
+    Objects.push_back(std::string(Path));
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    return Emit.emitObject(M, OS);
+}
+
+// Compiles the input in chunks of -stream top-level statements to an object
+// file. Every chunk is parsed, checked, generated, optimized and compiled in
+// a context of its own and written to a temporary object file before the
+// next one is parsed, so memory stays bounded as the program grows. The
+// objects are combined with a relocatable link at the end.
+static bool streamInput(const std::string &Input, llvm::StringRef Name, Emitter &Emit,
+                        llvm::raw_pwrite_stream &OS)
+{
+    Lexer Lex(Input);
+    Parser Parser(Lex);
+    Sema Semantic;
+    CodeGen CodeGenerator;
+    llvm::SmallVector<std::string, 16> Objects;
+    bool Ok = true;
+    while (Ok)
+    {
+        std::unique_ptr<AST> Tree(Parser.parseChunk(Stream));
+        if (Parser.hasError())
+        {
+            llvm::errs() << "Syntax errors occurred\n";
+            Ok = false;
+            break;
+        }
+        if (!Tree)
+            break;
+        if (Semantic.semantic(Tree.get()))
+        {
+            llvm::errs() << "Semantic errors occurred\n";
+            Ok = false;
+            break;
+        }
+
+        llvm::LLVMContext Ctx;
+        std::unique_ptr<llvm::Module> M = CodeGenerator.compileChunk(Tree.get(), Semantic.getFacts(), Ctx, Name);
+        Tree.reset();
+        Ok = M && emitTemporary(*M, Emit, Objects);
+    }
+
+    // main comes last, once the frame has all slots.
+    if (Ok)
+    {
+        llvm::LLVMContext Ctx;
+        std::unique_ptr<llvm::Module> M = CodeGenerator.compileMain(Ctx, Name);
+        Ok = emitTemporary(*M, Emit, Objects);
+    }
+
+    llvm::SmallString<128> Combined;
+    if (Ok)
+        Ok = !llvm::sys::fs::createTemporaryFile("gsm", "o", Combined) &&
+             Emitter::linkRelocatable(Objects, Combined);
+    if (Ok)
+    {
+        auto Buffer = llvm::MemoryBuffer::getFile(Combined, /*IsText=*/false,
+                                                  /*RequiresNullTerminator=*/false);
+        Ok = bool(Buffer);
+        if (Ok)
+            OS << (*Buffer)->getBuffer();
+        else
+            llvm::errs() << "Could not combine the object files of the chunks\n";
+    }
+    for (const std::string &Path : Objects)
+        llvm::sys::fs::remove(Path);
+    if (!Combined.empty())
+        llvm::sys::fs::remove(Combined);
+    return Ok;
+}
+
+// The main function of the program.
+int main(int argc, const char **argv)
+{
+    // Initialize the LLVM framework.
+    llvm::InitLLVM X(argc, argv);
+
+    // Parse command-line options.
+    llvm::cl::ParseCommandLineOptions(argc, argv, "GSM - the expression compiler\n");
+
+    // The fast tier generates code at -O0, and the Optimizer, ParallelCG and
+    // the JIT skip the work that -O0 still does (see --fast-compile). The
+    // code generator builds SSA form itself, and the frame of the parts is
+    // passed to them by pointer, so there is nothing for mem2reg to promote.
+    if (FastCompile)
+    {
+        OptLevel = 0;
+        PassPipeline = "";
+    }
+
+    // Pick the asynchronous runtime unless a runtime was given explicitly.
+    if (AsyncOutput)
+    {
+        if (!Runtime.getNumOccurrences())
+            Runtime = GSM_RUNTIME_ASYNC;
+        if (!RuntimeBitcode.getNumOccurrences())
+            RuntimeBitcode = GSM_RUNTIME_ASYNC_BC;
+    }
+
+    // The JIT binds the runtime functions to the synchronous runtime linked
+    // into gsm, so the asynchronous one would silently not be used.
+    if (AsyncOutput && Run)
+    {
+        llvm::errs() << "--async-output cannot be combined with --run\n";
+        return 1;
+    }
+
+    if (InlineRuntime && RuntimeBitcode.empty())
+    {
+        llvm::errs() << "No runtime bitcode available, use -runtime-bc=<file>\n";
+        return 1;
+    }
+
+    // Only a bitcode container can hold more than one program.
+    if (Inputs.empty())
+        Inputs.push_back("");
+    if (Inputs.size() > 1 && !EmitBitcode)
+    {
+        llvm::errs() << "Multiple inputs are only supported with --emit-bc\n";
+        return 1;
+    }
+
+    // Replace file inputs by their contents. Debug information refers to
+    // the files by their absolute names.
+    std::vector<std::string> Names;
+    if (InputFiles)
+    {
+        for (std::string &Input : Inputs)
+        {
+            auto BufOrErr = llvm::MemoryBuffer::getFile(Input);
+            if (!BufOrErr)
+            {
+                llvm::errs() << Input << ": " << BufOrErr.getError().message() << "\n";
+                return 1;
+            }
+            llvm::SmallString<128> Name(Input);
+            llvm::sys::fs::make_absolute(Name);
+            Names.push_back(std::string(Name));
+            Input = (*BufOrErr)->getBuffer().str();
+        }
+    }
+
+    // Remarks are reported while the module is optimized, so they need a
+    // single pipeline on the context and no cached output.
+    if (SaveOptRecord && OptRecordFile.empty())
+        OptRecordFile = Output.empty() ? "gsm.opt.yaml" : Output + ".opt.yaml";
+    bool WantRemarks = !RemarksPassed.empty() || !RemarksMissed.empty() ||
+                       !RemarksAnalysis.empty() || !OptRecordFile.empty();
+    if (WantRemarks && Threads != 1)
+    {
+        llvm::errs() << "Optimization remarks are only supported with -threads=1\n";
+        return 1;
+    }
+
+    // Chunks are compiled straight to object code, one at a time.
+    if (Stream && (!(EmitObject || Link || Run) || Inputs.size() > 1 || Threads != 1 ||
+                   Multiversioning || InlineRuntime || WantRemarks))
+    {
+        llvm::errs() << "-stream needs -c, --link or --run, and supports neither multiple "
+                        "inputs, -threads, --multiversion, --inline-runtime nor remarks\n";
+        return 1;
+    }
+
+    // The cost report looks at the object code of a single program.
+    if (CostReportMode && (Inputs.size() > 1 || Stream || Threads != 1))
+    {
+        llvm::errs() << "--cost-report supports neither multiple inputs, -stream nor -threads\n";
+        return 1;
+    }
+
+    // Look the output up in the cache before running the frontend. A hit
+    // costs a map of the entry and the write of its contents.
+    std::unique_ptr<Cache> OutputCache;
+    std::string Key;
+    if (!CacheDir.empty() && !WantRemarks && !CostReportMode)
+    {
+        auto Policy = llvm::parseCachePruningPolicy(CachePolicy);
+        if (!Policy)
+        {
+            llvm::logAllUnhandledErrors(Policy.takeError(), llvm::errs(), "Invalid cache policy: ");
+            return 1;
+        }
+        OutputCache = std::make_unique<Cache>(CacheDir, *Policy);
+        Key = getCacheKey(argc, argv, Names);
+        if (std::unique_ptr<llvm::MemoryBuffer> Entry = OutputCache->lookup(Key))
+            return deliver(std::move(Entry), argv[0]);
+    }
+
+    // Native code needs the target machine for the host. Cached runs store
+    // the object code, so that a hit does not need the code generator, and
+    // parallel runs compile the object code on all threads. A CPU or
+    // multiversioning sets the target on the module for any output.
+    bool NativeCode = EmitObject || Link || CostReportMode ||
+                      (Run && (OutputCache || Threads != 1 || Stream));
+    std::unique_ptr<Emitter> Emit;
+    if (NativeCode || CPU.getNumOccurrences() || Multiversioning)
+    {
+        Emit = Emitter::create(OptLevel, CPU);
+        if (!Emit)
+            return 1;
+    }
+
+    // A streamed program goes straight from the source to the object code.
+    if (Stream)
+    {
+        llvm::SmallString<0> Buffer;
+        llvm::raw_svector_ostream OS(Buffer);
+        if (!streamInput(Inputs.front(), Names.empty() ? "<command line>" : Names.front(), *Emit,
+                         OS))
+            return 1;
+        if (OutputCache)
+            OutputCache->store(Key, Buffer);
+        return deliver(llvm::MemoryBuffer::getMemBuffer(Buffer, "calc.expr", false), argv[0]);
+    }
+
+    // Compile every input into its own module. The remark output outlives
+    // the context that writes to it.
+    Remarks OptRemarks;
+    auto Ctx = std::make_unique<llvm::LLVMContext>();
+    if (WantRemarks && !OptRemarks.setup(*Ctx, RemarksPassed, RemarksMissed,
+                                         RemarksAnalysis, OptRecordFile))
+        return 1;
+    CostReport Report;
+    llvm::SmallVector<std::unique_ptr<llvm::Module>, 1> Modules;
+    for (unsigned I = 0, E = Inputs.size(); I != E; ++I)
+    {
+        std::unique_ptr<llvm::Module> M =
+            compileInput(Inputs[I], Names.empty() ? "<command line>" : Names[I], *Ctx, Emit.get(),
+                         CostReportMode ? &Report : nullptr);
+        if (!M)
+            return 1;
+        if (Inputs.size() > 1)
+            M->setModuleIdentifier("calc.expr." + std::to_string(Modules.size()));
+        Modules.push_back(std::move(M));
+    }
+    OptRemarks.keep();
+
+    // Optimize the partitions of the modules in parallel, unless they are
+    // compiled to native code in parallel below.
+    ParallelCG Parallel(Threads, OptLevel, PassPipeline, Emit.get());
+    Parallel.setFast(FastCompile);
+    if (Threads != 1 && !NativeCode)
+    {
+        for (std::unique_ptr<llvm::Module> &M : Modules)
+        {
+            M = Parallel.optimize(std::move(M));
+            if (!M)
+                return 1;
+        }
+    }
+
+    // Estimate the cost of the statements from the object code instead of
+    // producing an output.
+    if (CostReportMode)
+    {
+        llvm::SmallString<0> Object;
+        llvm::raw_svector_ostream OS(Object);
+        if (!Emit->emitObject(*Modules.front(), OS))
+            return 1;
+        return Report.print(Object, *Emit->getTargetMachine(), Inputs.front(), llvm::outs()) ? 0 : 1;
+    }
+
+    // Run the module in-process and exit with the status of its main.
+    if (Run && !NativeCode)
+    {
+        JIT Jit(Emitter::getCodeGenLevel(OptLevel), FastCompile);
+        return Jit.run(std::move(Modules.front()), std::move(Ctx), argv[0]);
+    }
+
+    // Produce the output in memory: bitcode of all modules, the object code
+    // or the textual IR of the module.
+    llvm::SmallString<0> Buffer;
+    llvm::raw_svector_ostream OS(Buffer);
+    if (EmitBitcode)
+        Emitter::emitBitcode(Modules, OS);
+    else if (NativeCode)
+    {
+        bool Ok = Threads != 1 ? Parallel.emitObject(*Modules.front(), OS)
+                               : Emit->emitObject(*Modules.front(), OS);
+        if (!Ok)
+            return 1;
+    }
+    else
+        Modules.front()->print(OS, nullptr);
+
+    if (OutputCache)
+        OutputCache->store(Key, Buffer);
+    return deliver(llvm::MemoryBuffer::getMemBuffer(Buffer, "calc.expr", false), argv[0]);
+}
@@ -0,0 +1,212 @@
+#include "JIT.h"
+#include "runtime/gsmrt.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/ExecutionEngine/JITEventListener.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/Object/SymbolSize.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace llvm::orc;
+
+// Options for profiling JIT-compiled code with perf.
+static cl::opt<bool>
+    PerfMap("perf-map",
+            cl::desc("Write the symbols of JIT-compiled code to /tmp/perf-<pid>.map"),
+            cl::init(false));
+
+static cl::opt<bool>
+    JITDump("jitdump",
+            cl::desc("Write JIT-compiled code and its line table for perf inject --jit"),
+            cl::init(false));
+
+namespace
+{
+  // Appends every function of a loaded object to /tmp/perf-<pid>.map, the
+  // symbol table perf reads for anonymous executable memory. With debug
+  // information, the name of a function also carries the GSM position it
+  // starts at, e.g. "gsm.part.2 [prog.gsm:12]".
+  class PerfMapListener : public JITEventListener
+  {
+    std::unique_ptr<raw_fd_ostream> Map;
+
+  public:
+    PerfMapListener()
+    {
+      std::error_code EC;
+      std::string Path = "/tmp/perf-" + std::to_string(sys::Process::getProcessId()) + ".map";
+      Map = std::make_unique<raw_fd_ostream>(Path, EC, sys::fs::OF_Append);
+      if (EC)
+      {
+        errs() << Path << ": " << EC.message() << "\n";
+        Map.reset();
+      }
+    }
+
+    void notifyObjectLoaded(ObjectKey, const object::ObjectFile &Obj,
+                            const RuntimeDyld::LoadedObjectInfo &L) override
+    {
+      if (!Map)
+        return;
+
+      // The object for debuggers has the sections at their load addresses.
+      object::OwningBinary<object::ObjectFile> DebugObj = L.getObjectForDebug(Obj);
+      if (!DebugObj.getBinary())
+        return;
+      std::unique_ptr<DIContext> Context = DWARFContext::create(*DebugObj.getBinary());
+
+      for (const auto &SymSize : object::computeSymbolSizes(*DebugObj.getBinary()))
+      {
+        const object::SymbolRef &Sym = SymSize.first;
+        Expected<object::SymbolRef::Type> Type = Sym.getType();
+        Expected<StringRef> Name = Sym.getName();
+        Expected<uint64_t> Addr = Sym.getAddress();
+        Expected<object::section_iterator> Sec = Sym.getSection();
+        if (!Type || !Name || !Addr || !Sec || *Type != object::SymbolRef::ST_Function)
+        {
+          consumeError(Type.takeError());
+          consumeError(Name.takeError());
+          consumeError(Addr.takeError());
+          consumeError(Sec.takeError());
+          continue;
+        }
+
+        *Map << format_hex_no_prefix(*Addr, 1) << " " << format_hex_no_prefix(SymSize.second, 1)
+             << " " << *Name;
+        DILineInfo Line = Context->getLineInfoForAddress({*Addr, (*Sec)->getIndex()});
+        if (Line.Line)
+          *Map << " [" << Line.FileName << ":" << Line.Line << "]";
+        *Map << "\n";
+      }
+      Map->flush();
+    }
+  };
+
+  // Report an ORC error in the style of the other compiler errors.
+  int reportError(Error Err)
+  {
+    logAllUnhandledErrors(std::move(Err), errs(), "JIT error: ");
+    return 1;
+  }
+
+  // Create an LLJIT instance for the host that generates code at the given
+  // level, with the runtime functions bound to the copy of the runtime
+  // library linked into the compiler, instead of being looked up in a
+  // shared library. Everything else, such as the C library functions of a
+  // runtime linked into the module, is looked up in the process.
+  Expected<std::unique_ptr<LLJIT>> createJIT(CodeGenOpt::Level CodeGenLevel, bool SmallCode)
+  {
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+
+    auto JTMB = JITTargetMachineBuilder::detectHost();
+    if (!JTMB)
+      return JTMB.takeError();
+    JTMB->setCodeGenOptLevel(CodeGenLevel);
+    if (SmallCode)
+    {
+      // Functions and data outside the module are reached through the
+      // stubs and the GOT the linking layer creates, so they may be
+      // anywhere. The sections of the module are allocated close together.
+      JTMB->setCodeModel(CodeModel::Small);
+      JTMB->setRelocationModel(Reloc::PIC_);
+    }
+
+    // Register the perf listeners with the object linking layer. They live
+    // as long as the process, since perf reads their output after it exits.
+    LLJITBuilder Builder;
+    Builder.setJITTargetMachineBuilder(std::move(*JTMB));
+    if (PerfMap || JITDump)
+    {
+      Builder.setObjectLinkingLayerCreator([](ExecutionSession &ES, const Triple &)
+      {
+        auto Layer = std::make_unique<RTDyldObjectLinkingLayer>(
+            ES, []() { return std::make_unique<SectionMemoryManager>(); });
+        if (PerfMap)
+        {
+          static PerfMapListener Listener;
+          Layer->registerJITEventListener(Listener);
+        }
+        if (JITDump)
+        {
+          if (JITEventListener *Listener = JITEventListener::createPerfJITEventListener())
+            Layer->registerJITEventListener(*Listener);
+          else
+            errs() << "jitdump is not supported by this LLVM build\n";
+        }
+        return Expected<std::unique_ptr<ObjectLayer>>(std::move(Layer));
+      });
+    }
+
+    auto J = Builder.create();
+    if (!J)
+      return J.takeError();
+
+    SymbolMap Runtime;
+    Runtime[(*J)->mangleAndIntern("gsm_write")] = JITEvaluatedSymbol(
+        pointerToJITTargetAddress(&gsm_write), JITSymbolFlags::Exported);
+    Runtime[(*J)->mangleAndIntern("gsm_flush")] = JITEvaluatedSymbol(
+        pointerToJITTargetAddress(&gsm_flush), JITSymbolFlags::Exported);
+    Runtime[(*J)->mangleAndIntern("gsm_cpu_level")] = JITEvaluatedSymbol(
+        pointerToJITTargetAddress(&gsm_cpu_level), JITSymbolFlags::Exported);
+    Runtime[(*J)->mangleAndIntern("gsm_profile_write")] = JITEvaluatedSymbol(
+        pointerToJITTargetAddress(&gsm_profile_write), JITSymbolFlags::Exported);
+    Runtime[(*J)->mangleAndIntern("gsm_fuel_exhausted")] = JITEvaluatedSymbol(
+        pointerToJITTargetAddress(&gsm_fuel_exhausted), JITSymbolFlags::Exported);
+    Runtime[(*J)->mangleAndIntern("gsm_write_text")] = JITEvaluatedSymbol(
+        pointerToJITTargetAddress(&gsm_write_text), JITSymbolFlags::Exported);
+    if (Error Err = (*J)->getMainJITDylib().define(absoluteSymbols(std::move(Runtime))))
+      return std::move(Err);
+
+    auto Process = DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        (*J)->getDataLayout().getGlobalPrefix());
+    if (!Process)
+      return Process.takeError();
+    (*J)->getMainJITDylib().addGenerator(std::move(*Process));
+    return J;
+  }
+
+  // Call the generated main like the C runtime would.
+  int runMain(LLJIT &J, const char *ProgName)
+  {
+    auto MainSym = J.lookup("main");
+    if (!MainSym)
+      return reportError(MainSym.takeError());
+
+    auto *MainFn = jitTargetAddressToFunction<int (*)(int, char **)>(MainSym->getAddress());
+    char *Argv[] = {const_cast<char *>(ProgName), nullptr};
+    return MainFn(1, Argv);
+  }
+}
+
+int JIT::run(std::unique_ptr<Module> M, std::unique_ptr<LLVMContext> Ctx,
+             const char *ProgName)
+{
+  auto J = createJIT(CodeGenLevel, SmallCode);
+  if (!J)
+    return reportError(J.takeError());
+
+  if (Error Err = (*J)->addIRModule(ThreadSafeModule(std::move(M), std::move(Ctx))))
+    return reportError(std::move(Err));
+  return runMain(**J, ProgName);
+}
+
+int JIT::runObject(std::unique_ptr<MemoryBuffer> Obj, const char *ProgName)
+{
+  auto J = createJIT(CodeGenLevel, SmallCode);
+  if (!J)
+    return reportError(J.takeError());
+
+  if (Error Err = (*J)->addObjectFile(std::move(Obj)))
+    return reportError(std::move(Err));
+  return runMain(**J, ProgName);
+}
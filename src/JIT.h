@@ -0,0 +1,37 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+
+class JIT
+{
+  llvm::CodeGenOpt::Level CodeGenLevel; // level modules are compiled at
+  bool SmallCode;                       // small code model, for --fast-compile
+
+public:
+  // Code is generated at the level the optimization level maps to, see
+  // Emitter::getCodeGenLevel. CodeGenOpt::None selects the fast instruction
+  // selector and register allocator, which generate code in a fraction of
+  // the time. The JIT uses the large code model by default, whose calls the
+  // fast instruction selector leaves to the slow one; SmallCode generates
+  // position-independent code for the small code model instead, which it
+  // selects completely.
+  JIT(llvm::CodeGenOpt::Level CodeGenLevel, bool SmallCode)
+      : CodeGenLevel(CodeGenLevel), SmallCode(SmallCode) {}
+
+  // Compiles the module in-process with an ORC LLJIT instance, binds the
+  // runtime functions to the runtime linked into gsm and calls main. Returns the exit
+  // code of main, or 1 if the module could not be compiled.
+  int run(std::unique_ptr<llvm::Module> M,
+          std::unique_ptr<llvm::LLVMContext> Ctx,
+          const char *ProgName);
+
+  // Like the above, but links and runs an already compiled object file.
+  int runObject(std::unique_ptr<llvm::MemoryBuffer> Obj, const char *ProgName);
+};
+
+#endif
@@ -1,89 +1,103 @@
-#ifndef LEXER_H // conditional compilations(checks whether a macro is not defined)
-#define LEXER_H
-
-#include "llvm/ADT/StringRef.h"        // encapsulates a pointer to a C string and its length
-#include "llvm/Support/MemoryBuffer.h" // read-only access to a block of memory, filled with the content of a file
-
-class Lexer;
-
-class Token
-{
-    friend class Lexer; // Lexer can access private and protected members of Token
-
-public:
-    enum TokenKind : unsigned short
-    {
-        eoi,     // end of input
-        unknown, // in case of error at the lexical level
-        ident,
-        number,
-        equal,
-        comma,
-        semicolon,
-        plus,
-        minus,
-        star,
-        slash,
-        l_paren,
-        r_paren,
-        KW_int,
-        power,
-        percent,
-        greater_than,
-        less_than,
-        greater_than_or_equal,
-        less_than_or_equal,
-        equality,
-        not_equal,
-        KW_and,
-        KW_or,
-        plus_equal,
-        minus_equal,
-        slash_equal,
-        star_equal,
-        KW_if,
-        KW_elif,
-        KW_else,
-        KW_begin,
-        KW_end,
-        KW_loop,
-        KW_colon
-    };
-
-private:
-    TokenKind Kind;
-    llvm::StringRef Text; // points to the start of the text of the token
-
-public:
-    TokenKind getKind() const { return Kind; }
-    llvm::StringRef getText() const { return Text; }
-
-    // to test if the token is of a certain kind
-    bool is(TokenKind K) const { return Kind == K; }
-    bool isOneOf(TokenKind K1, TokenKind K2) const
-    {
-        return is(K1) || is(K2);
-    }
-    template <typename... Ts>
-    bool isOneOf(TokenKind K1, TokenKind K2, Ts... Ks)
-        const { return is(K1) || isOneOf(K2, Ks...); }
-};
-
-class Lexer
-{
-    const char *BufferStart; // pointer to the beginning of the input
-    const char *BufferPtr;   // pointer to the next unprocessed character
-
-public:
-    Lexer(const llvm::StringRef &Buffer)
-    {
-        BufferStart = Buffer.begin();
-        BufferPtr = BufferStart;
-    }
-
-    void next(Token &token); // return the next token
-
-private:
-    void formToken(Token &Result, const char *TokEnd, Token::TokenKind Kind);
-};
+#ifndef LEXER_H // conditional compilations(checks whether a macro is not defined)
+#define LEXER_H
+
+#include "llvm/ADT/StringRef.h"        // encapsulates a pointer to a C string and its length
+#include "llvm/Support/MemoryBuffer.h" // read-only access to a block of memory, filled with the content of a file
+
+class Lexer;
+
+// position of a token or AST node in the input, both counted from 1; a line
+// of 0 means the position is not known
+struct SourceLoc
+{
+    unsigned Line = 0;
+    unsigned Col = 0;
+};
+
+class Token
+{
+    friend class Lexer; // Lexer can access private and protected members of Token
+
+public:
+    enum TokenKind : unsigned short
+    {
+        eoi,     // end of input
+        unknown, // in case of error at the lexical level
+        ident,
+        number,
+        equal,
+        comma,
+        semicolon,
+        plus,
+        minus,
+        star,
+        slash,
+        l_paren,
+        r_paren,
+        KW_int,
+        power,
+        percent,
+        greater_than,
+        less_than,
+        greater_than_or_equal,
+        less_than_or_equal,
+        equality,
+        not_equal,
+        KW_and,
+        KW_or,
+        plus_equal,
+        minus_equal,
+        slash_equal,
+        star_equal,
+        KW_if,
+        KW_elif,
+        KW_else,
+        KW_begin,
+        KW_end,
+        KW_loop,
+        KW_colon
+    };
+
+private:
+    TokenKind Kind;
+    llvm::StringRef Text; // points to the start of the text of the token
+    SourceLoc Loc;        // where the token starts
+
+public:
+    TokenKind getKind() const { return Kind; }
+    llvm::StringRef getText() const { return Text; }
+    SourceLoc getLoc() const { return Loc; }
+
+    // to test if the token is of a certain kind
+    bool is(TokenKind K) const { return Kind == K; }
+    bool isOneOf(TokenKind K1, TokenKind K2) const
+    {
+        return is(K1) || is(K2);
+    }
+    template <typename... Ts>
+    bool isOneOf(TokenKind K1, TokenKind K2, Ts... Ks)
+        const { return is(K1) || isOneOf(K2, Ks...); }
+};
+
+class Lexer
+{
+    const char *BufferStart; // pointer to the beginning of the input
+    const char *BufferPtr;   // pointer to the next unprocessed character
+    const char *LineStart;   // pointer to the beginning of the current line
+    unsigned Line;           // number of the current line
+
+public:
+    Lexer(const llvm::StringRef &Buffer)
+    {
+        BufferStart = Buffer.begin();
+        BufferPtr = BufferStart;
+        LineStart = BufferStart;
+        Line = 1;
+    }
+
+    void next(Token &token); // return the next token
+
+private:
+    void formToken(Token &Result, const char *TokEnd, Token::TokenKind Kind);
+};
 #endif
\ No newline at end of file
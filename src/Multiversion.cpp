@@ -0,0 +1,114 @@
+#include "Multiversion.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/CFG.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+using namespace llvm;
+
+namespace
+{
+  // The clones from the highest level down; the original CPU of the
+  // module is the fallback for level 1.
+  const struct
+  {
+    int Level;
+    const char *CPU;
+  } Levels[] = {{4, "x86-64-v4"}, {3, "x86-64-v3"}, {2, "x86-64-v2"}};
+
+  // Returns true if the function has a loop worth compiling for a wider ISA.
+  bool isVersioned(Function &F)
+  {
+    if (F.isDeclaration() || F.doesNotAccessMemory())
+      return false;
+    SmallVector<std::pair<const BasicBlock *, const BasicBlock *>, 4> BackEdges;
+    FindFunctionBackedges(F, BackEdges);
+    return !BackEdges.empty();
+  }
+
+  Function *cloneFor(Function &F, const Twine &Suffix, StringRef CPU)
+  {
+    ValueToValueMapTy VMap;
+    Function *Clone = CloneFunction(&F, VMap);
+    Clone->setName(F.getName() + "." + Suffix);
+    Clone->setLinkage(GlobalValue::InternalLinkage);
+    if (!CPU.empty())
+    {
+      // The CPU name implies the features of the level.
+      Clone->addFnAttr("target-cpu", CPU);
+      Clone->removeFnAttr("target-features");
+    }
+    return Clone;
+  }
+}
+
+bool Multiversion::run(Module &M)
+{
+  if (Triple(M.getTargetTriple()).getArch() != Triple::x86_64)
+  {
+    errs() << "Multiversioning is only supported for x86-64 targets\n";
+    return false;
+  }
+
+  LLVMContext &Ctx = M.getContext();
+  Type *Int32Ty = Type::getInt32Ty(Ctx);
+  auto *LevelVar = new GlobalVariable(M, Int32Ty, false, GlobalValue::InternalLinkage,
+                                      ConstantInt::get(Int32Ty, 1), "gsm.cpu.level");
+
+  SmallVector<Function *, 8> Fns;
+  for (Function &F : M)
+  {
+    if (isVersioned(F))
+      Fns.push_back(&F);
+  }
+
+  for (Function *F : Fns)
+  {
+    SmallVector<std::pair<int, Function *>, 4> Clones;
+    for (auto &L : Levels)
+      Clones.push_back({L.Level, cloneFor(*F, L.CPU, L.CPU)});
+    Function *Default = cloneFor(*F, "default", "");
+
+    // The function keeps its name and linkage and becomes the dispatcher.
+    GlobalValue::LinkageTypes Linkage = F->getLinkage();
+    F->deleteBody();
+    F->setLinkage(Linkage);
+    F->removeFnAttr(Attribute::NoInline);
+
+    BasicBlock *BB = BasicBlock::Create(Ctx, "entry", F);
+    IRBuilder<> Builder(BB);
+    Value *Level = Builder.CreateLoad(Int32Ty, LevelVar, "level");
+    SmallVector<Value *, 4> Args;
+    for (Argument &A : F->args())
+      Args.push_back(&A);
+
+    for (auto &C : Clones)
+    {
+      BasicBlock *CallBB = BasicBlock::Create(Ctx, "dispatch", F);
+      BasicBlock *NextBB = BasicBlock::Create(Ctx, "dispatch.next", F);
+      Builder.CreateCondBr(Builder.CreateICmpSGE(Level, ConstantInt::get(Int32Ty, C.first)),
+                           CallBB, NextBB);
+      Builder.SetInsertPoint(CallBB);
+      CallInst *Call = Builder.CreateCall(C.second, Args);
+      Call->setTailCall();
+      F->getReturnType()->isVoidTy() ? Builder.CreateRetVoid() : Builder.CreateRet(Call);
+      Builder.SetInsertPoint(NextBB);
+    }
+    CallInst *Call = Builder.CreateCall(Default, Args);
+    Call->setTailCall();
+    F->getReturnType()->isVoidTy() ? Builder.CreateRetVoid() : Builder.CreateRet(Call);
+  }
+
+  // Detect the level once, before main runs any versioned code.
+  if (Function *Main = M.getFunction("main"))
+  {
+    if (!Main->isDeclaration())
+    {
+      FunctionCallee LevelFn = M.getOrInsertFunction("gsm_cpu_level", FunctionType::get(Int32Ty, false));
+      IRBuilder<> Builder(&Main->getEntryBlock(), Main->getEntryBlock().getFirstInsertionPt());
+      Builder.CreateStore(Builder.CreateCall(LevelFn), LevelVar);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,18 @@
+#ifndef MULTIVERSION_H
+#define MULTIVERSION_H
+
+#include "llvm/IR/Module.h"
+
+// Multiversion compiles the functions with loops for several x86-64 ISA
+// levels. Every such function is cloned once per level, with the level as
+// its target CPU, and its body is replaced by a dispatch to the best clone.
+// main asks the runtime for the level of the CPU once at startup.
+class Multiversion
+{
+public:
+  // Versions the functions of a configured module. Returns false if the
+  // target of the module is not x86-64.
+  bool run(llvm::Module &M);
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "Optimizer.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Transforms/IPO/Internalize.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+namespace
+{
+  // Map the command line level to the PassBuilder optimization level.
+  OptimizationLevel getLevel(int OptLevel)
+  {
+    switch (OptLevel)
+    {
+    case 0:
+      return OptimizationLevel::O0;
+    case 1:
+      return OptimizationLevel::O1;
+    case 2:
+      return OptimizationLevel::O2;
+    case -1:
+      return OptimizationLevel::Os;
+    case -2:
+      return OptimizationLevel::Oz;
+    default:
+      return OptimizationLevel::O3;
+    }
+  }
+}
+
+bool Optimizer::run(Module &M)
+{
+  return prepare(M) && optimize(M);
+}
+
+bool Optimizer::prepare(Module &M)
+{
+  // Nothing GSM code calls can throw. Saying so spares the fast tier the
+  // unwind tables, which would only be needed by debuggers and profilers.
+  if (Fast)
+  {
+    for (Function &F : M)
+      F.setDoesNotThrow();
+  }
+
+  // Never hand a broken module to the optimizer or the printer.
+  if (!Fast && verifyModule(M, &errs()))
+  {
+    errs() << "Generated module is broken\n";
+    return false;
+  }
+
+  // Pull in the runtime functions the module uses. Everything but main is
+  // made internal, so the optimizer may inline and then drop them.
+  if (!RuntimeBC.empty())
+  {
+    SMDiagnostic Err;
+    std::unique_ptr<Module> Runtime = parseIRFile(RuntimeBC, Err, M.getContext());
+    if (!Runtime)
+    {
+      Err.print("gsm", errs());
+      return false;
+    }
+    Runtime->setTargetTriple(M.getTargetTriple());
+    Runtime->setDataLayout(M.getDataLayout());
+    if (Linker::linkModules(M, std::move(Runtime), Linker::LinkOnlyNeeded))
+      return false;
+    internalizeModule(M, [](const GlobalValue &GV)
+                      { return GV.getName() == "main"; });
+  }
+  return true;
+}
+
+bool Optimizer::optimize(Module &M)
+{
+  if (Fast)
+    return true;
+
+  // Create the analysis managers and register them with each other.
+  PassBuilder PB(TM);
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  // Build the pipeline: a custom pipeline wins over the -O level.
+  ModulePassManager MPM;
+  if (!Pipeline.empty())
+  {
+    if (Error Err = PB.parsePassPipeline(MPM, Pipeline))
+    {
+      errs() << toString(std::move(Err)) << "\n";
+      return false;
+    }
+  }
+  else if (OptLevel == 0)
+    MPM = PB.buildO0DefaultPipeline(OptimizationLevel::O0);
+  else
+    MPM = PB.buildPerModuleDefaultPipeline(getLevel(OptLevel));
+
+  // Check the result again, a custom pipeline may contain anything.
+  MPM.addPass(VerifierPass());
+  MPM.run(M, MAM);
+  return true;
+}
@@ -0,0 +1,42 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+#include <string>
+
+class Optimizer
+{
+  int OptLevel;         // 0-3, or -1 for -Os and -2 for -Oz
+  std::string Pipeline; // custom pass pipeline, overrides OptLevel if set
+  llvm::TargetMachine *TM; // target to optimize for, may be null
+  std::string RuntimeBC;   // runtime bitcode to link in first, if set
+  bool Fast = false;       // skip the verifier and the pipeline, see setFast
+
+public:
+  Optimizer(int OptLevel, llvm::StringRef Pipeline,
+            llvm::TargetMachine *TM = nullptr)
+      : OptLevel(OptLevel), Pipeline(Pipeline.str()), TM(TM) {}
+
+  // Links the runtime library bitcode into every module before it is
+  // optimized, so that its functions can be inlined into main.
+  void setRuntime(llvm::StringRef Bitcode) { RuntimeBC = Bitcode.str(); }
+
+  // Hands the module to the code generator as it was generated, without
+  // verifying it and without running any passes, for --fast-compile. Its
+  // functions are marked nounwind, so that they get no unwind tables.
+  void setFast(bool On) { Fast = On; }
+
+  // Verifies the module and runs the selected pass pipeline on it.
+  // Returns false if the module is broken or the pipeline is invalid.
+  bool run(llvm::Module &M);
+
+  // The two steps of run(): prepare() verifies the module and links the
+  // runtime, optimize() runs the pipeline. Partitions of a prepared module
+  // may be optimized separately.
+  bool prepare(llvm::Module &M);
+  bool optimize(llvm::Module &M);
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include "ParallelCG.h"
+#include "Emitter.h"
+#include "Optimizer.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include <atomic>
+
+using namespace llvm;
+
+void ParallelCG::split(Module &M, SmallVectorImpl<SmallString<0>> &Parts)
+{
+  // There is no point in more partitions than functions.
+  unsigned NumFns = 0;
+  for (Function &F : M)
+    NumFns += !F.isDeclaration();
+  unsigned N = std::max(1u, std::min(NumFns, hardware_concurrency(Threads).compute_thread_count()));
+
+  // Internal functions called across partitions become hidden globals.
+  SplitModule(M, N, [&](std::unique_ptr<Module> Part)
+              {
+                Parts.emplace_back();
+                raw_svector_ostream OS(Parts.back());
+                WriteBitcodeToFile(*Part, OS); });
+}
+
+bool ParallelCG::cloneEmitters(unsigned N, SmallVectorImpl<std::unique_ptr<Emitter>> &Emitters)
+{
+  // Target machines are not shared between threads. The targets must be
+  // initialized before the threads start.
+  for (unsigned I = 0; I != N; ++I)
+  {
+    Emitters.push_back(Emit->clone());
+    if (!Emitters.back())
+      return false;
+  }
+  return true;
+}
+
+std::unique_ptr<Module> ParallelCG::optimize(std::unique_ptr<Module> M)
+{
+  SmallVector<SmallString<0>, 8> Parts;
+  split(*M, Parts);
+  SmallVector<std::unique_ptr<Emitter>, 8> Emitters;
+  if (Emit && !cloneEmitters(Parts.size(), Emitters))
+    return nullptr;
+
+  // Every thread reads its partition into its own context and writes the
+  // optimized partition back as bitcode.
+  std::atomic<bool> Failed(false);
+  {
+    ThreadPool Pool(hardware_concurrency(Threads));
+    for (unsigned I = 0, E = Parts.size(); I != E; ++I)
+    {
+      Pool.async([&, I]
+                 {
+        SmallString<0> &Part = Parts[I];
+        LLVMContext Ctx;
+        auto PartM = parseBitcodeFile(MemoryBufferRef(Part, "partition"), Ctx);
+        if (!PartM)
+        {
+          consumeError(PartM.takeError());
+          Failed = true;
+          return;
+        }
+        Optimizer Opt(OptLevel, Pipeline, Emit ? Emitters[I]->getTargetMachine() : nullptr);
+        Opt.setFast(Fast);
+        if (!Opt.optimize(**PartM))
+        {
+          Failed = true;
+          return;
+        }
+        Part.clear();
+        raw_svector_ostream OS(Part);
+        WriteBitcodeToFile(**PartM, OS); });
+    }
+    Pool.wait();
+  }
+  if (Failed)
+    return nullptr;
+
+  // Link the partitions back together in the original context.
+  std::unique_ptr<Module> Result;
+  for (SmallString<0> &Part : Parts)
+  {
+    auto PartM = parseBitcodeFile(MemoryBufferRef(Part, "partition"), M->getContext());
+    if (!PartM)
+    {
+      errs() << toString(PartM.takeError()) << "\n";
+      return nullptr;
+    }
+    if (!Result)
+      Result = std::move(*PartM);
+    else if (Linker::linkModules(*Result, std::move(*PartM)))
+      return nullptr;
+  }
+  return Result;
+}
+
+bool ParallelCG::emitObject(Module &M, raw_pwrite_stream &OS)
+{
+  SmallVector<SmallString<0>, 8> Parts;
+  split(M, Parts);
+
+  SmallVector<std::unique_ptr<Emitter>, 8> Emitters;
+  if (!cloneEmitters(Parts.size(), Emitters))
+    return false;
+
+  // Every thread compiles its partition to an object file in memory.
+  std::atomic<bool> Failed(false);
+  {
+    ThreadPool Pool(hardware_concurrency(Threads));
+    for (unsigned I = 0, E = Parts.size(); I != E; ++I)
+    {
+      Pool.async([&, I]
+                 {
+        LLVMContext Ctx;
+        auto PartM = parseBitcodeFile(MemoryBufferRef(Parts[I], "partition"), Ctx);
+        if (!PartM)
+        {
+          consumeError(PartM.takeError());
+          Failed = true;
+          return;
+        }
+        Optimizer Opt(OptLevel, Pipeline, Emitters[I]->getTargetMachine());
+        Opt.setFast(Fast);
+        SmallString<0> Object;
+        raw_svector_ostream ObjOS(Object);
+        if (!Opt.optimize(**PartM) || !Emitters[I]->emitObject(**PartM, ObjOS))
+        {
+          Failed = true;
+          return;
+        }
+        Parts[I] = std::move(Object); });
+    }
+    Pool.wait();
+  }
+  if (Failed)
+    return false;
+  if (Parts.size() == 1)
+  {
+    OS << Parts.front();
+    return true;
+  }
+
+  // Combine the objects with a relocatable link.
+  SmallVector<std::string, 8> Objects;
+  SmallString<128> Combined;
+  bool Ok = !sys::fs::createTemporaryFile("gsm", "o", Combined);
+  for (SmallString<0> &Part : Parts)
+  {
+    SmallString<128> Path;
+    int FD;
+    if (!Ok || sys::fs::createTemporaryFile("gsm-part", "o", FD, Path))
+    {
+      Ok = false;
+      break;
+    }
+    raw_fd_ostream PartOS(FD, /*shouldClose=*/true);
+    PartOS << Part;
+    Objects.push_back(std::string(Path.str()));
+  }
+  if (Ok)
+    Ok = Emitter::linkRelocatable(Objects, Combined);
+  if (Ok)
+  {
+    auto Buffer = MemoryBuffer::getFile(Combined, /*IsText=*/false,
+                                        /*RequiresNullTerminator=*/false);
+    Ok = bool(Buffer);
+    if (Ok)
+      OS << (*Buffer)->getBuffer();
+  }
+  if (!Ok)
+    errs() << "Could not combine the object files of the partitions\n";
+  for (const std::string &Path : Objects)
+    sys::fs::remove(Path);
+  if (!Combined.empty())
+    sys::fs::remove(Combined);
+  return Ok;
+}
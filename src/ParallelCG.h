@@ -0,0 +1,50 @@
+#ifndef PARALLELCG_H
+#define PARALLELCG_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+
+class Emitter;
+
+// ParallelCG optimizes and compiles a module on a thread pool. The module is
+// split into partitions of whole functions, one per thread, and every
+// partition is moved into a context of its own, so that the threads share
+// nothing. The module must be prepared by the Optimizer, and is most useful
+// after -split-functions broke main up into parts.
+class ParallelCG
+{
+  unsigned Threads;     // 0 uses all cores
+  int OptLevel;         // like Optimizer
+  std::string Pipeline; // like Optimizer
+  Emitter *Emit;        // target of the serial compilation, if any
+  bool Fast = false;    // like Optimizer
+
+  // Creates an emitter like Emit for every partition.
+  bool cloneEmitters(unsigned N, llvm::SmallVectorImpl<std::unique_ptr<Emitter>> &Emitters);
+
+  // Splits the module and writes every partition as bitcode.
+  void split(llvm::Module &M, llvm::SmallVectorImpl<llvm::SmallString<0>> &Parts);
+
+public:
+  // The threads optimize and compile for the target, CPU and features of
+  // Emit, like the serial compilation does. Without an emitter, partitions
+  // are optimized without a target, and cannot be compiled.
+  ParallelCG(unsigned Threads, int OptLevel, llvm::StringRef Pipeline, Emitter *Emit)
+      : Threads(Threads), OptLevel(OptLevel), Pipeline(Pipeline.str()), Emit(Emit) {}
+
+  // Runs no passes on the partitions, see Optimizer::setFast.
+  void setFast(bool On) { Fast = On; }
+
+  // Optimizes the partitions in parallel and links them back into a module
+  // in the context of M. Returns nullptr on errors.
+  std::unique_ptr<llvm::Module> optimize(std::unique_ptr<llvm::Module> M);
+
+  // Optimizes and compiles the partitions in parallel, and writes the
+  // relocatable object file combining them to the stream.
+  bool emitObject(llvm::Module &M, llvm::raw_pwrite_stream &OS);
+};
+
+#endif
@@ -1,532 +1,525 @@
-#include "Parser.h"
-
-// main point is that the whole input has been consumed
-AST *Parser::parse()
-{
-    AST *Res = parseGoal();
-    return Res;
-}
-
-AST *Parser::parseGoal()
-{
-    llvm::SmallVector<Expr *> exprs;
-    Expr *a;
-    while (!Tok.is(Token::eoi))
-    {
-        switch (Tok.getKind())
-        {
-        case Token::KW_int:
-            a = parseDec();
-
-            if (!Tok.is(Token::semicolon))
-            {
-                error();
-                goto _error;
-            }
-            if (a)
-                exprs.push_back(a);
-            else
-                goto _error;
-            break;
-        case Token::ident:
-            a = parseAssign();
-
-            if (!Tok.is(Token::semicolon))
-            {
-                error();
-                goto _error;
-            }
-            if (a)
-                exprs.push_back(a);
-            else
-                goto _error;
-            break;
-        case Token::KW_if:
-            a = parseCondition();
-
-            if (a)
-                exprs.push_back(a);
-            else
-                goto _error;
-            break;
-        case Token::KW_loop:
-
-            a = parseLoop();
-
-            if (!Tok.is(Token::KW_end))
-            {
-                error();
-                goto _error;
-            }
-            if (a)
-                exprs.push_back(a);
-            else
-                goto _error;
-            break;
-
-        default:
-            goto _error;
-            break;
-        }
-        advance(); // TODO: watch this part
-    }
-    return new GSM(exprs);
-_error:
-    while (Tok.getKind() != Token::eoi)
-        advance();
-        exit(0);
-    return nullptr;
-}
-
-Expr *Parser::parseDec()
-{
-    Expr *E;
-    llvm::SmallVector<llvm::StringRef, 8> Vars;
-    int counter =0;
-
-    if (expect(Token::KW_int))
-        goto _error;
-
-    advance();
-
-    if (expect(Token::ident))
-        goto _error;
-    Vars.push_back(Tok.getText());
-    counter++;
-    advance();
-
-    while (Tok.is(Token::comma))
-    {
-        advance();
-        if (expect(Token::ident))
-            goto _error;
-        Vars.push_back(Tok.getText());
-        counter++;
-        advance();
-    }
-
-    if (Tok.is(Token::equal))
-    {
-        advance();
-        E = parseExpr();
-        counter--;
-        while (Tok.is(Token::comma) && counter>0)
-        {
-            counter--;
-            advance();
-            E = parseExpr();
-        }
-        
-    }
-
-    if (expect(Token::semicolon))
-        goto _error;
-
-    return new Declaration(Vars, E);
-_error: // TODO: Check this later in case of error :)
-    while (Tok.getKind() != Token::eoi)
-        advance();
-         exit(0);
-    return nullptr;
-}
-
-Expr *Parser::parseAssign()
-{
-    Expr *E;
-    Factor *F;
-    F = (Factor *)(parseFactor());
-
-    if (!Tok.is(Token::equal))
-    {
-        error();
-        return nullptr;
-    }
-
-    advance();
-    E = parseExpr();
-    return new Assignment(F, E);
-}
-
-Expr *Parser::parseExpr()
-{
-    Expr *Left = parseTerm();
-    BinaryOp_Attribution::Operator Op;
-    while (Tok.isOneOf(Token::plus_equal, Token::minus_equal, Token::star_equal, Token::slash_equal))
-    {
-
-        switch (Tok.getKind())
-        {
-        case Token::plus_equal:
-            Op = BinaryOp_Attribution::Plus_equal;
-            break;
-        case Token::minus_equal:
-            Op = BinaryOp_Attribution::Minus_equal;
-            break;
-        case Token::star_equal:
-            Op = BinaryOp_Attribution::Star_equal;
-            break;
-        case Token::slash_equal:
-            Op = BinaryOp_Attribution::Slash_equal;
-            break;
-        default:
-            /*TODO*/
-            break;
-        }
-        advance();
-        Expr *Right = parseTerm();
-        Left = new BinaryOp_Attribution(Op, Left, Right);
-    }
-    return Left;
-}
-
-Expr *Parser::parseTerm()
-{
-    Expr *Left = parseFactor();
-    BinaryOp_Logical::Operator Op;
-    while (Tok.is(Token::KW_or))
-    {
-
-        if (Tok.is(Token::KW_or))
-            Op = BinaryOp_Logical::KW_OR;
-        else
-            error();
-        advance();
-        Expr *Right = parseFactor();
-        Left = new BinaryOp_Logical(Op, Left, Right);
-    }
-    return Left;
-}
-
-Expr *Parser::parseFactor()
-{
-    Expr *Left = parseFactor_eq_neq();
-    BinaryOp_Logical::Operator Op;
-    while (Tok.is(Token::KW_and))
-    {
-
-        if (Tok.is(Token::KW_and))
-            Op = BinaryOp_Logical::KW_AND;
-        else
-            error();
-        advance();
-        Expr *Right = parseFactor_eq_neq();
-        Left = new BinaryOp_Logical(Op, Left, Right);
-    }
-    return Left;
-}
-
-Expr *Parser::parseFactor_eq_neq()
-{
-    Expr *Left = parseFactor_GE_LE();
-    BinaryOp_Relational::Operator Op;
-    if (Tok.is(Token::equality) || Tok.is(Token::not_equal))
-    {
-
-        if (Tok.is(Token::equality))
-            Op = BinaryOp_Relational::Equality;
-        else if (Tok.is(Token::not_equal))
-            Op = BinaryOp_Relational::Not_equal;
-
-        advance();
-        Expr *Right = parseFactor_GE_LE();
-        Left = new BinaryOp_Relational(Op, Left, Right);
-    }
-    return Left;
-}
-
-Expr *Parser::parseFactor_GE_LE()
-{
-    Expr *Left = parseFactor_G_L();
-    BinaryOp_Relational::Operator Op;
-    if (Tok.is(Token::greater_than_or_equal) || Tok.is(Token::less_than_or_equal))
-    {
-
-        if (Tok.is(Token::greater_than_or_equal))
-            Op = BinaryOp_Relational::Greater_than_or_equal;
-        else if (Tok.is(Token::less_than_or_equal))
-            Op = BinaryOp_Relational::Less_than_or_equal;
-
-        advance();
-        Expr *Right = parseFactor_G_L();
-        Left = new BinaryOp_Relational(Op, Left, Right);
-    }
-
-    return Left;
-}
-
-Expr *Parser::parseFactor_G_L()
-{
-    Expr *Left = parseFactor_plus_minus();
-    BinaryOp_Relational::Operator Op;
-    if (Tok.isOneOf(Token::greater_than, Token::less_than))
-    {
-
-        if (Tok.is(Token::greater_than))
-            Op = BinaryOp_Relational::Greater_than;
-        else if (Tok.is(Token::less_than))
-            Op = BinaryOp_Relational::Less_than;
-
-    advance();
-    Expr *Right = parseFactor_plus_minus();
-    Left = new BinaryOp_Relational(Op, Left, Right);
-    }
-    return Left;
-}
-
-Expr *Parser::parseFactor_plus_minus()
-{
-    Expr *Left = parseFactor_mul_div_perc();
-    BinaryOp_Calculators::Operator Op;
-    while (Tok.isOneOf(Token::plus, Token::minus))
-    {
-
-        if (Tok.is(Token::plus))
-            Op = BinaryOp_Calculators::Plus;
-        else if (Tok.is(Token::minus))
-            Op = BinaryOp_Calculators::Minus;
-        else
-            error();
-        advance();
-        Expr *Right = parseFactor_mul_div_perc();
-        Left = new BinaryOp_Calculators(Op, Left, Right);
-    }
-    return Left;
-}
-
-Expr *Parser::parseFactor_mul_div_perc()
-{
-    Expr *Left = parseFactor_power();
-    BinaryOp_Calculators::Operator Op;
-    while (Tok.isOneOf(Token::star, Token::slash, Token::percent))
-    {
-
-        if (Tok.is(Token::star))
-            Op = BinaryOp_Calculators::Mul;
-        else if (Tok.is(Token::slash))
-            Op = BinaryOp_Calculators::Div;
-        else if (Tok.is(Token::percent))
-            Op = BinaryOp_Calculators::Percent;
-        else
-            error();
-        advance();
-        Expr *Right = parseFactor_power();
-        Left = new BinaryOp_Calculators(Op, Left, Right);
-    }
-    return Left;
-}
-
-Expr *Parser::parseFactor_power()
-{
-    Expr *Left = parseFactor_terminals();
-    BinaryOp_Calculators::Operator Op;
-    while (Tok.is(Token::power))
-    {
-
-        Op = BinaryOp_Calculators::Power;
-        advance();
-        Expr *Right = parseFactor_terminals();
-        Left = new BinaryOp_Calculators(Op, Left, Right);
-    }
-    return Left;
-}
-
-Expr *Parser::parseFactor_terminals()
-{
-    Expr *Res = nullptr;
-    switch (Tok.getKind())
-    {
-    case Token::number:
-        Res = new Factor(Factor::Number, Tok.getText());
-        advance();
-        break;
-    case Token::ident:
-        Res = new Factor(Factor::Ident, Tok.getText());
-        advance();
-        break;
-    case Token::l_paren:
-        advance();
-        Res = parseExpr();
-        if (!consume(Token::r_paren))
-            break;
-    default: // error handling
-        if (!Res)
-            error();
-        while (!Tok.isOneOf(Token::r_paren, Token::star, Token::plus, Token::minus, Token::slash, Token::eoi))
-            advance();
-        break;
-    }
-    return Res;
-}
-
-Expr *Parser::parseCondition()
-{
-    llvm::SmallVector<Expr *> exprs;
-    Expr *a;
-    if (expect(Token::KW_if))
-        goto _error;
-
-    advance();
-
-    a = parseTerm();
-
-    if (expect(Token::KW_colon))
-        goto _error;
-
-    advance();
-
-    if (expect(Token::KW_begin))
-        goto _error;
-
-    advance();
-
-    while (!Tok.is(Token::KW_end))
-    {
-
-        a = parseAssign();
-        if (!Tok.is(Token::semicolon))
-        {
-            error();
-            goto _error;
-        }
-        if (a)
-            exprs.push_back(a);
-        else
-            goto _error;
-
-        advance();
-    }
-
-    if (expect(Token::KW_end))
-        goto _error;
-
-    advance();
-
-    while (Tok.is(Token::KW_elif))
-    {
-        if (expect(Token::KW_elif))
-            goto _error;
-
-        advance();
-
-        a = parseTerm();
-
-        if (expect(Token::KW_colon))
-            goto _error;
-
-        advance();
-
-        if (expect(Token::KW_begin))
-            goto _error;
-
-        advance();
-
-        while (!Tok.is(Token::KW_end))
-        {
-
-            a = parseAssign();
-            if (!Tok.is(Token::semicolon))
-            {
-                error();
-                goto _error;
-            }
-            if (a)
-                exprs.push_back(a);
-            else
-                goto _error;
-
-            advance();
-        }
-    }
-
-    if (expect(Token::KW_end))
-        goto _error;
-
-    advance();
-
-    if (Tok.is(Token::KW_else))
-    {
-
-        advance();
-
-        if (expect(Token::KW_colon))
-            goto _error;
-
-        advance();
-
-        if (expect(Token::KW_begin))
-            goto _error;
-
-        advance();
-
-        while (!Tok.is(Token::KW_end))
-        {
-
-            a = parseAssign();
-            if (!Tok.is(Token::semicolon))
-            {
-                error();
-                goto _error;
-            }
-            if (a)
-                exprs.push_back(a);
-            else
-                goto _error;
-
-            advance();
-        }
-    }
-
-    return new Condition(exprs);
-_error: // TODO: Check this later in case of error :)
-    while (Tok.getKind() != Token::eoi)
-        advance();
-        exit(0);
-    return nullptr;
-}
-
-Expr *Parser::parseLoop()
-{
-    llvm::SmallVector<Expr *> exprs;
-    Expr *a;
-    if (expect(Token::KW_loop))
-        goto _error;
-
-    advance();
-
-    a = parseTerm();
-
-    if (expect(Token::KW_colon))
-        goto _error;
-
-    advance();
-
-    if (expect(Token::KW_begin))
-        goto _error;
-
-    advance();
-
-    while (!Tok.is(Token::KW_end))
-    {
-
-        a = parseAssign();
-
-        if (!Tok.is(Token::semicolon))
-        {
-            error();
-            goto _error;
-        }
-        if (a)
-            exprs.push_back(a);
-        else
-            goto _error;
-
-        advance();
-    }
-
-    return new Loop(exprs);
-_error: // TODO: Check this later in case of error :)
-    while (Tok.getKind() != Token::eoi)
-        advance();
-        exit(0);
-    return nullptr;
+#include "Parser.h"
+
+// main point is that the whole input has been consumed
+AST *Parser::parse()
+{
+    AST *Res = parseGoal();
+    return Res;
+}
+
+AST *Parser::parseGoal()
+{
+    llvm::SmallVector<Expr *> exprs;
+    while (!Tok.is(Token::eoi))
+    {
+        Expr *a = parseStatement();
+        if (!a)
+            goto _error;
+        exprs.push_back(a);
+    }
+    return new GSM(exprs);
+_error:
+    while (Tok.getKind() != Token::eoi)
+        advance();
+        exit(0);
+    return nullptr;
+}
+
+AST *Parser::parseChunk(unsigned N)
+{
+    llvm::SmallVector<Expr *> exprs;
+    while (!Tok.is(Token::eoi) && exprs.size() < N)
+    {
+        Expr *a = parseStatement();
+        if (!a)
+            goto _error;
+        exprs.push_back(a);
+    }
+    if (exprs.empty())
+        return nullptr;
+    return new GSM(exprs);
+_error:
+    while (Tok.getKind() != Token::eoi)
+        advance();
+        exit(0);
+    return nullptr;
+}
+
+// parses one top-level statement and moves past it
+Expr *Parser::parseStatement()
+{
+    Expr *a;
+    switch (Tok.getKind())
+    {
+    case Token::KW_int:
+        a = parseDec();
+
+        if (!Tok.is(Token::semicolon))
+        {
+            error();
+            return nullptr;
+        }
+        break;
+    case Token::ident:
+        a = parseAssign();
+
+        if (!Tok.is(Token::semicolon))
+        {
+            error();
+            return nullptr;
+        }
+        break;
+    case Token::KW_if:
+        return parseCondition(); // the condition already moved past its last end
+    case Token::KW_loop:
+
+        a = parseLoop();
+
+        if (!Tok.is(Token::KW_end))
+        {
+            error();
+            return nullptr;
+        }
+        break;
+
+    default:
+        return nullptr;
+    }
+    if (a)
+        advance(); // TODO: watch this part
+    return a;
+}
+
+Expr *Parser::parseDec()
+{
+    Expr *E = nullptr;
+    llvm::SmallVector<llvm::StringRef, 8> Vars;
+    int counter =0;
+    SourceLoc Loc = Tok.getLoc();
+    Expr *Res;
+
+    if (expect(Token::KW_int))
+        goto _error;
+
+    advance();
+
+    if (expect(Token::ident))
+        goto _error;
+    Vars.push_back(Tok.getText());
+    counter++;
+    advance();
+
+    while (Tok.is(Token::comma))
+    {
+        advance();
+        if (expect(Token::ident))
+            goto _error;
+        Vars.push_back(Tok.getText());
+        counter++;
+        advance();
+    }
+
+    if (Tok.is(Token::equal))
+    {
+        advance();
+        E = parseExpr();
+        counter--;
+        while (Tok.is(Token::comma) && counter>0)
+        {
+            counter--;
+            advance();
+            E = parseExpr();
+        }
+        
+    }
+
+    if (expect(Token::semicolon))
+        goto _error;
+
+    Res = new Declaration(Vars, E);
+    Res->setLoc(Loc);
+    return Res;
+_error: // TODO: Check this later in case of error :)
+    while (Tok.getKind() != Token::eoi)
+        advance();
+         exit(0);
+    return nullptr;
+}
+
+Expr *Parser::parseAssign()
+{
+    Expr *E;
+    Factor *F;
+    SourceLoc Loc = Tok.getLoc();
+    F = (Factor *)(parseFactor());
+
+    if (!Tok.is(Token::equal))
+    {
+        error();
+        return nullptr;
+    }
+
+    advance();
+    E = parseExpr();
+    Expr *Res = new Assignment(F, E);
+    Res->setLoc(Loc);
+    return Res;
+}
+
+Expr *Parser::parseExpr()
+{
+    Expr *Left = parseTerm();
+    BinaryOp_Attribution::Operator Op;
+    while (Tok.isOneOf(Token::plus_equal, Token::minus_equal, Token::star_equal, Token::slash_equal))
+    {
+
+        switch (Tok.getKind())
+        {
+        case Token::plus_equal:
+            Op = BinaryOp_Attribution::Plus_equal;
+            break;
+        case Token::minus_equal:
+            Op = BinaryOp_Attribution::Minus_equal;
+            break;
+        case Token::star_equal:
+            Op = BinaryOp_Attribution::Star_equal;
+            break;
+        case Token::slash_equal:
+            Op = BinaryOp_Attribution::Slash_equal;
+            break;
+        default:
+            /*TODO*/
+            break;
+        }
+        SourceLoc OpLoc = Tok.getLoc();
+        advance();
+        Expr *Right = parseTerm();
+        Left = new BinaryOp_Attribution(Op, Left, Right);
+        Left->setLoc(OpLoc);
+    }
+    return Left;
+}
+
+Expr *Parser::parseTerm()
+{
+    Expr *Left = parseFactor();
+    BinaryOp_Logical::Operator Op;
+    while (Tok.is(Token::KW_or))
+    {
+
+        if (Tok.is(Token::KW_or))
+            Op = BinaryOp_Logical::KW_OR;
+        else
+            error();
+        SourceLoc OpLoc = Tok.getLoc();
+        advance();
+        Expr *Right = parseFactor();
+        Left = new BinaryOp_Logical(Op, Left, Right);
+        Left->setLoc(OpLoc);
+    }
+    return Left;
+}
+
+Expr *Parser::parseFactor()
+{
+    Expr *Left = parseFactor_eq_neq();
+    BinaryOp_Logical::Operator Op;
+    while (Tok.is(Token::KW_and))
+    {
+
+        if (Tok.is(Token::KW_and))
+            Op = BinaryOp_Logical::KW_AND;
+        else
+            error();
+        SourceLoc OpLoc = Tok.getLoc();
+        advance();
+        Expr *Right = parseFactor_eq_neq();
+        Left = new BinaryOp_Logical(Op, Left, Right);
+        Left->setLoc(OpLoc);
+    }
+    return Left;
+}
+
+Expr *Parser::parseFactor_eq_neq()
+{
+    Expr *Left = parseFactor_GE_LE();
+    BinaryOp_Relational::Operator Op;
+    if (Tok.is(Token::equality) || Tok.is(Token::not_equal))
+    {
+
+        if (Tok.is(Token::equality))
+            Op = BinaryOp_Relational::Equality;
+        else if (Tok.is(Token::not_equal))
+            Op = BinaryOp_Relational::Not_equal;
+
+        SourceLoc OpLoc = Tok.getLoc();
+        advance();
+        Expr *Right = parseFactor_GE_LE();
+        Left = new BinaryOp_Relational(Op, Left, Right);
+        Left->setLoc(OpLoc);
+    }
+    return Left;
+}
+
+Expr *Parser::parseFactor_GE_LE()
+{
+    Expr *Left = parseFactor_G_L();
+    BinaryOp_Relational::Operator Op;
+    if (Tok.is(Token::greater_than_or_equal) || Tok.is(Token::less_than_or_equal))
+    {
+
+        if (Tok.is(Token::greater_than_or_equal))
+            Op = BinaryOp_Relational::Greater_than_or_equal;
+        else if (Tok.is(Token::less_than_or_equal))
+            Op = BinaryOp_Relational::Less_than_or_equal;
+
+        SourceLoc OpLoc = Tok.getLoc();
+        advance();
+        Expr *Right = parseFactor_G_L();
+        Left = new BinaryOp_Relational(Op, Left, Right);
+        Left->setLoc(OpLoc);
+    }
+
+    return Left;
+}
+
+Expr *Parser::parseFactor_G_L()
+{
+    Expr *Left = parseFactor_plus_minus();
+    BinaryOp_Relational::Operator Op;
+    if (Tok.isOneOf(Token::greater_than, Token::less_than))
+    {
+
+        if (Tok.is(Token::greater_than))
+            Op = BinaryOp_Relational::Greater_than;
+        else if (Tok.is(Token::less_than))
+            Op = BinaryOp_Relational::Less_than;
+
+    SourceLoc OpLoc = Tok.getLoc();
+    advance();
+    Expr *Right = parseFactor_plus_minus();
+    Left = new BinaryOp_Relational(Op, Left, Right);
+    Left->setLoc(OpLoc);
+    }
+    return Left;
+}
+
+Expr *Parser::parseFactor_plus_minus()
+{
+    Expr *Left = parseFactor_mul_div_perc();
+    BinaryOp_Calculators::Operator Op;
+    while (Tok.isOneOf(Token::plus, Token::minus))
+    {
+
+        if (Tok.is(Token::plus))
+            Op = BinaryOp_Calculators::Plus;
+        else if (Tok.is(Token::minus))
+            Op = BinaryOp_Calculators::Minus;
+        else
+            error();
+        SourceLoc OpLoc = Tok.getLoc();
+        advance();
+        Expr *Right = parseFactor_mul_div_perc();
+        Left = new BinaryOp_Calculators(Op, Left, Right);
+        Left->setLoc(OpLoc);
+    }
+    return Left;
+}
+
+Expr *Parser::parseFactor_mul_div_perc()
+{
+    Expr *Left = parseFactor_power();
+    BinaryOp_Calculators::Operator Op;
+    while (Tok.isOneOf(Token::star, Token::slash, Token::percent))
+    {
+
+        if (Tok.is(Token::star))
+            Op = BinaryOp_Calculators::Mul;
+        else if (Tok.is(Token::slash))
+            Op = BinaryOp_Calculators::Div;
+        else if (Tok.is(Token::percent))
+            Op = BinaryOp_Calculators::Percent;
+        else
+            error();
+        SourceLoc OpLoc = Tok.getLoc();
+        advance();
+        Expr *Right = parseFactor_power();
+        Left = new BinaryOp_Calculators(Op, Left, Right);
+        Left->setLoc(OpLoc);
+    }
+    return Left;
+}
+
+Expr *Parser::parseFactor_power()
+{
+    Expr *Left = parseFactor_terminals();
+    BinaryOp_Calculators::Operator Op;
+    while (Tok.is(Token::power))
+    {
+
+        Op = BinaryOp_Calculators::Power;
+        SourceLoc OpLoc = Tok.getLoc();
+        advance();
+        Expr *Right = parseFactor_terminals();
+        Left = new BinaryOp_Calculators(Op, Left, Right);
+        Left->setLoc(OpLoc);
+    }
+    return Left;
+}
+
+Expr *Parser::parseFactor_terminals()
+{
+    Expr *Res = nullptr;
+    switch (Tok.getKind())
+    {
+    case Token::number:
+        Res = new Factor(Factor::Number, Tok.getText());
+        Res->setLoc(Tok.getLoc());
+        advance();
+        break;
+    case Token::ident:
+        Res = new Factor(Factor::Ident, Tok.getText());
+        Res->setLoc(Tok.getLoc());
+        advance();
+        break;
+    case Token::l_paren:
+        advance();
+        Res = parseExpr();
+        if (!consume(Token::r_paren))
+            break;
+    default: // error handling
+        if (!Res)
+            error();
+        while (!Tok.isOneOf(Token::r_paren, Token::star, Token::plus, Token::minus, Token::slash, Token::eoi))
+            advance();
+        break;
+    }
+    return Res;
+}
+
+Expr *Parser::parseCondition()
+{
+    Condition::ArmVector arms;
+    Expr *cond;
+    SourceLoc Loc = Tok.getLoc();
+    Expr *Res;
+    if (expect(Token::KW_if))
+        goto _error;
+
+    // the if arm and any elif arms: a condition followed by a block
+    do
+    {
+        advance();
+
+        cond = parseTerm();
+        if (!cond)
+            goto _error;
+
+        arms.push_back({cond, {}});
+        if (parseBlock(arms.back().Body))
+            goto _error;
+    } while (Tok.is(Token::KW_elif));
+
+    // an optional else arm without a condition
+    if (Tok.is(Token::KW_else))
+    {
+        advance();
+
+        arms.push_back({nullptr, {}});
+        if (parseBlock(arms.back().Body))
+            goto _error;
+    }
+
+    Res = new Condition(arms);
+    Res->setLoc(Loc);
+    return Res;
+_error: // TODO: Check this later in case of error :)
+    while (Tok.getKind() != Token::eoi)
+        advance();
+        exit(0);
+    return nullptr;
+}
+
+// parses ": begin {assignment ;} end" including the closing end
+bool Parser::parseBlock(llvm::SmallVector<Expr *> &exprs)
+{
+    Expr *a;
+    if (consume(Token::KW_colon))
+        return true;
+
+    if (consume(Token::KW_begin))
+        return true;
+
+    while (!Tok.is(Token::KW_end))
+    {
+
+        a = parseAssign();
+        if (!Tok.is(Token::semicolon))
+        {
+            error();
+            return true;
+        }
+        if (!a)
+            return true;
+        exprs.push_back(a);
+
+        advance();
+    }
+
+    advance();
+    return false;
+}
+
+Expr *Parser::parseLoop()
+{
+    llvm::SmallVector<Expr *> exprs;
+    Expr *a;
+    Expr *cond;
+    SourceLoc Loc = Tok.getLoc();
+    Expr *Res;
+    if (expect(Token::KW_loop))
+        goto _error;
+
+    advance();
+
+    cond = parseTerm();
+    if (!cond)
+        goto _error;
+
+    if (expect(Token::KW_colon))
+        goto _error;
+
+    advance();
+
+    if (expect(Token::KW_begin))
+        goto _error;
+
+    advance();
+
+    while (!Tok.is(Token::KW_end))
+    {
+
+        a = parseAssign();
+
+        if (!Tok.is(Token::semicolon))
+        {
+            error();
+            goto _error;
+        }
+        if (a)
+            exprs.push_back(a);
+        else
+            goto _error;
+
+        advance();
+    }
+
+    Res = new Loop(cond, exprs);
+    Res->setLoc(Loc);
+    return Res;
+_error: // TODO: Check this later in case of error :)
+    while (Tok.getKind() != Token::eoi)
+        advance();
+        exit(0);
+    return nullptr;
 }
\ No newline at end of file
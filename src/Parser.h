@@ -1,75 +1,81 @@
-#ifndef PARSER_H
-#define PARSER_H
-
-#include "AST.h"
-#include "Lexer.h"
-#include "llvm/Support/raw_ostream.h"
-
-class Parser
-{
-    Lexer &Lex;    // retrieve the next token from the input
-    Token Tok;     // stores the next token
-    bool HasError; // indicates if an error was detected
-
-    void error()
-    {
-        llvm::errs() << "Unexpected: " << Tok.getText() << "\n";
-        HasError = true;
-    }
-
-    // retrieves the next token from the lexer.expect()
-    // tests whether the look-ahead is of the expected kind
-    void advance() { Lex.next(Tok); }
-
-    bool expect(Token::TokenKind Kind)
-    {
-        if (Tok.getKind() != Kind)
-        {
-            error();
-            return true;
-        }
-        return false;
-    }
-
-    // retrieves the next token if the look-ahead is of the expected kind
-    bool consume(Token::TokenKind Kind)
-    {
-        if (expect(Kind))
-            return true;
-        advance();
-        return false;
-    }
-
-    AST *parseGoal();
-    Expr *parseDec();
-    Expr *parseAssign();
-    Expr *parseExpr();
-    Expr *parseTerm();
-    Expr *parseFactor();
-    Expr *parseFactor_and();
-    Expr *parseFactor_eq_neq();
-    Expr *parseFactor_GE_LE();
-    Expr *parseFactor_G_L();
-    Expr *parseFactor_plus_minus();
-    Expr *parseFactor_mul_div_perc();
-    Expr *parseFactor_power();
-    Expr *parseFactor_terminals();
-
-    /*TODO:*/
-    Expr *parseCondition();
-    Expr *parseLoop();
-
-public:
-    // initializes all members and retrieves the first token
-    Parser(Lexer &Lex) : Lex(Lex), HasError(false)
-    {
-        advance();
-    }
-
-    // get the value of error flag
-    bool hasError() { return HasError; }
-
-    AST *parse();
-};
-
+#ifndef PARSER_H
+#define PARSER_H
+
+#include "AST.h"
+#include "Lexer.h"
+#include "llvm/Support/raw_ostream.h"
+
+class Parser
+{
+    Lexer &Lex;    // retrieve the next token from the input
+    Token Tok;     // stores the next token
+    bool HasError; // indicates if an error was detected
+
+    void error()
+    {
+        llvm::errs() << "Unexpected: " << Tok.getText() << "\n";
+        HasError = true;
+    }
+
+    // retrieves the next token from the lexer.expect()
+    // tests whether the look-ahead is of the expected kind
+    void advance() { Lex.next(Tok); }
+
+    bool expect(Token::TokenKind Kind)
+    {
+        if (Tok.getKind() != Kind)
+        {
+            error();
+            return true;
+        }
+        return false;
+    }
+
+    // retrieves the next token if the look-ahead is of the expected kind
+    bool consume(Token::TokenKind Kind)
+    {
+        if (expect(Kind))
+            return true;
+        advance();
+        return false;
+    }
+
+    AST *parseGoal();
+    Expr *parseStatement();
+    Expr *parseDec();
+    Expr *parseAssign();
+    Expr *parseExpr();
+    Expr *parseTerm();
+    Expr *parseFactor();
+    Expr *parseFactor_and();
+    Expr *parseFactor_eq_neq();
+    Expr *parseFactor_GE_LE();
+    Expr *parseFactor_G_L();
+    Expr *parseFactor_plus_minus();
+    Expr *parseFactor_mul_div_perc();
+    Expr *parseFactor_power();
+    Expr *parseFactor_terminals();
+
+    /*TODO:*/
+    Expr *parseCondition();
+    bool parseBlock(llvm::SmallVector<Expr *> &exprs);
+    Expr *parseLoop();
+
+public:
+    // initializes all members and retrieves the first token
+    Parser(Lexer &Lex) : Lex(Lex), HasError(false)
+    {
+        advance();
+    }
+
+    // get the value of error flag
+    bool hasError() { return HasError; }
+
+    AST *parse();
+
+    // parses the next N top-level statements at most, so that a program
+    // can be compiled piece by piece; returns nullptr at the end of input
+    AST *parseChunk(unsigned N);
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "Profile.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+std::unique_ptr<Profile> Profile::read(StringRef Filename)
+{
+  auto Buffer = MemoryBuffer::getFile(Filename);
+  if (!Buffer)
+  {
+    errs() << "Cannot read profile " << Filename << ": "
+           << Buffer.getError().message() << "\n";
+    return nullptr;
+  }
+
+  // gsm-profile <hash> <count>, then one counter per line.
+  SmallVector<StringRef, 64> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n', -1, false);
+  SmallVector<StringRef, 3> Header;
+  if (!Lines.empty())
+    Lines.front().split(Header, ' ');
+  uint64_t Hash;
+  unsigned N;
+  if (Header.size() != 3 || Header[0] != "gsm-profile" ||
+      Header[1].getAsInteger(10, Hash) || Header[2].getAsInteger(10, N) ||
+      Lines.size() != N + 1)
+  {
+    errs() << "Malformed profile " << Filename << "\n";
+    return nullptr;
+  }
+
+  std::vector<uint64_t> Counts(N);
+  for (unsigned I = 0; I < N; ++I)
+  {
+    if (Lines[I + 1].getAsInteger(10, Counts[I]))
+    {
+      errs() << "Malformed profile " << Filename << "\n";
+      return nullptr;
+    }
+  }
+  return std::unique_ptr<Profile>(new Profile(Hash, std::move(Counts)));
+}
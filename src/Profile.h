@@ -0,0 +1,30 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Profile holds the counters written by a program compiled with
+// -profile-generate. The hash identifies the shape of the program the
+// counters belong to: the sequence of if/elif/else arms and loops.
+class Profile
+{
+  uint64_t Hash;
+  std::vector<uint64_t> Counts;
+
+  Profile(uint64_t Hash, std::vector<uint64_t> Counts)
+      : Hash(Hash), Counts(std::move(Counts)) {}
+
+public:
+  // Reads a profile file. Returns nullptr and reports the problem if the
+  // file cannot be read or is malformed.
+  static std::unique_ptr<Profile> read(llvm::StringRef Filename);
+
+  uint64_t getHash() const { return Hash; }
+  llvm::ArrayRef<uint64_t> getCounts() const { return Counts; }
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "Remarks.h"
+#include "llvm/IR/DiagnosticHandler.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/LLVMRemarkStreamer.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/Regex.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+namespace
+{
+  // Enables the remarks of each kind for the passes matching its pattern
+  // and prints them like compiler diagnostics.
+  class RemarkHandler : public DiagnosticHandler
+  {
+    std::unique_ptr<Regex> Passed, Missed, Analysis;
+
+    static bool matches(const std::unique_ptr<Regex> &Pattern, StringRef PassName)
+    {
+      return Pattern && Pattern->match(PassName);
+    }
+
+  public:
+    RemarkHandler(std::unique_ptr<Regex> Passed, std::unique_ptr<Regex> Missed,
+                  std::unique_ptr<Regex> Analysis)
+        : Passed(std::move(Passed)), Missed(std::move(Missed)), Analysis(std::move(Analysis)) {}
+
+    bool isPassedOptRemarkEnabled(StringRef PassName) const override
+    {
+      return matches(Passed, PassName);
+    }
+    bool isMissedOptRemarkEnabled(StringRef PassName) const override
+    {
+      return matches(Missed, PassName);
+    }
+    bool isAnalysisRemarkEnabled(StringRef PassName) const override
+    {
+      return matches(Analysis, PassName);
+    }
+    bool isAnyRemarkEnabled() const override
+    {
+      return Passed || Missed || Analysis;
+    }
+
+    // Print an enabled remark as "file:line:col: remark: message [-Rpass=pass]".
+    // Other diagnostics are printed by the context.
+    bool handleDiagnostics(const DiagnosticInfo &DI) override
+    {
+      auto *Remark = dyn_cast<DiagnosticInfoOptimizationBase>(&DI);
+      if (!Remark)
+        return false;
+      if (!Remark->isEnabled())
+        return true;
+
+      StringRef Flag = Remark->isPassed() ? "-Rpass" : Remark->isMissed() ? "-Rpass-missed"
+                                                                          : "-Rpass-analysis";
+      auto *Located = dyn_cast<DiagnosticInfoWithLocationBase>(Remark);
+      if (Located && Located->isLocationAvailable())
+        errs() << Located->getLocationStr() << ": ";
+      errs() << "remark: " << Remark->getMsg() << " [" << Flag << "=" << Remark->getPassName()
+             << "]\n";
+      return true;
+    }
+  };
+
+  // Compile a -Rpass pattern, or leave it disabled if it is empty.
+  bool compilePattern(StringRef Text, std::unique_ptr<Regex> &Pattern)
+  {
+    if (Text.empty())
+      return true;
+    Pattern = std::make_unique<Regex>(Text);
+    std::string Err;
+    if (!Pattern->isValid(Err))
+    {
+      errs() << "Invalid remark pattern '" << Text << "': " << Err << "\n";
+      return false;
+    }
+    return true;
+  }
+}
+
+bool Remarks::setup(LLVMContext &Ctx, StringRef Passed, StringRef Missed, StringRef Analysis,
+                    StringRef RecordFile)
+{
+  std::unique_ptr<Regex> PassedRE, MissedRE, AnalysisRE;
+  if (!compilePattern(Passed, PassedRE) || !compilePattern(Missed, MissedRE) ||
+      !compilePattern(Analysis, AnalysisRE))
+    return false;
+  if (PassedRE || MissedRE || AnalysisRE)
+    Ctx.setDiagnosticHandler(std::make_unique<RemarkHandler>(
+        std::move(PassedRE), std::move(MissedRE), std::move(AnalysisRE)));
+
+  // The record gets the remarks of all passes, whether they are printed
+  // or not.
+  if (!RecordFile.empty())
+  {
+    auto FileOrErr = setupLLVMOptimizationRemarks(Ctx, RecordFile, "", "yaml", false);
+    if (!FileOrErr)
+    {
+      logAllUnhandledErrors(FileOrErr.takeError(), errs(), "Cannot save optimization record: ");
+      return false;
+    }
+    Record = std::move(*FileOrErr);
+  }
+  return true;
+}
+
+void Remarks::keep()
+{
+  if (Record)
+    Record->keep();
+}
@@ -0,0 +1,28 @@
+#ifndef REMARKS_H
+#define REMARKS_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include <memory>
+
+// Remarks makes the optimization remarks of the passes that run on a
+// context visible: remarks of passes matching the -Rpass patterns are
+// printed at the GSM file:line:column they refer to, and all remarks can be
+// saved as a YAML optimization record.
+class Remarks
+{
+  std::unique_ptr<llvm::ToolOutputFile> Record;
+
+public:
+  // Installs the remark handler on the context. Empty patterns and an empty
+  // record file name are not enabled. Returns false and reports the problem
+  // if a pattern is invalid or the record file cannot be created.
+  bool setup(llvm::LLVMContext &Ctx, llvm::StringRef Passed, llvm::StringRef Missed,
+             llvm::StringRef Analysis, llvm::StringRef RecordFile);
+
+  // Keeps the record file once all passes have run.
+  void keep();
+};
+
+#endif
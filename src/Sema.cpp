@@ -1,138 +1,102 @@
-#include "Sema.h"
-#include "llvm/ADT/StringSet.h"
-#include "llvm/Support/raw_ostream.h"
-
-namespace {
-class InputCheck : public ASTVisitor {
-  llvm::StringSet<> Scope; // StringSet to store declared variables
-  bool HasError; // Flag to indicate if an error occurred
-
-  enum ErrorType { Twice, Not }; // Enum to represent error types: Twice - variable declared twice, Not - variable not declared
-
-  void error(ErrorType ET, llvm::StringRef V) {
-    // Function to report errors
-    llvm::errs() << "Variable " << V << " is "
-                 << (ET == Twice ? "already" : "not")
-                 << " declared\n";
-    HasError = true; // Set error flag to true
-    exit(0);
-  }
-
-public:
-  InputCheck() : HasError(false) {} // Constructor
-
-  bool hasError() { return HasError; } // Function to check if an error occurred
-
-  // Visit function for Goal nodes
-  virtual void visit(GSM &Node) override { 
-    for (auto I = Node.begin(), E = Node.end(); I != E; ++I)
-    {
-      (*I)->accept(*this); // Visit each child node
-    }
-  };
-
-  // Visit function for Factor nodes
-  virtual void visit(Factor &Node) override {
-    if (Node.getKind() == Factor::Ident) {
-      // Check if identifier is in the scope
-      if (Scope.find(Node.getVal()) == Scope.end())
-        error(Not, Node.getVal());
-    }
-  };
-
-  // Visit function for BinaryOp nodes
-  virtual void visit(BinaryOp_Calculators &Node) override {
-    if (Node.getLeft())
-      Node.getLeft()->accept(*this);
-    else
-      HasError = true;
-
-    auto right = Node.getRight();
-    if (right)
-      right->accept(*this);
-    else
-      HasError = true;
-
-    if (Node.getOperator() == BinaryOp_Calculators::Operator::Div && right) {
-      Factor * f = (Factor *)right;
-
-      if (right && f->getKind() == Factor::ValueKind::Number) {
-        int intval;
-        f->getVal().getAsInteger(10, intval);
-        if (intval == 0) {
-          llvm::errs() << "Division by zero is not allowed." << "\n";
-          HasError = true;
-        }
-      }
-    }
-  };
-
-  // Visit function for Assignment nodes
-  virtual void visit(Assignment &Node) override {
-    Factor *dest = Node.getLeft();
-
-    dest->accept(*this);
-
-    if (dest->getKind() == Factor::Number) {
-        llvm::errs() << "Assignment destination must be an identifier.";
-        HasError = true;
-    }
-
-    if (dest->getKind() == Factor::Ident) {
-      // Check if the identifier is in the scope
-      if (Scope.find(dest->getVal()) == Scope.end())
-        error(Not, dest->getVal());
-    }
-
-    if (Node.getRight())
-      Node.getRight()->accept(*this);
-  };
-
-  virtual void visit(Declaration &Node) override {
-    for (auto I = Node.begin(), E = Node.end(); I != E;
-         ++I) {
-      if (!Scope.insert(*I).second)
-        error(Twice, *I); // If the insertion fails (element already exists in Scope), report a "Twice" error
-    }
-    if (Node.getExpr())
-      Node.getExpr()->accept(*this); // If the Declaration node has an expression, recursively visit the expression node
-  };
-
-  virtual void visit(BinaryOp_Relational &Node) override {};
-
-  virtual void visit(BinaryOp_Logical &Node) override {};
-
-  virtual void visit(BinaryOp_Attribution &Node) override {};
-
-  virtual void visit(Loop &Node) {};
-  
-  // virtual void visit(Condition &Node) override {
-  //   if (Node.getLeft())
-  //     Node.getLeft()->accept(*this);
-  //   else HasError = true;
-  //   auto right = Node.getRight();
-  //   if (right)
-  //     right->accept(*this);
-  //   else HasError = true;
-  //   if (Node.getLeft()->getKind() != Factor::Ident && Node.getLeft()->getKind() != Factor::Number) {
-  //     llvm::errs() << "Left side of condition must be an identifier or a number.\n";
-  //   }
-
-  //   if (Node.getRight()->getKind() != Factor::Ident && Node.getRight()->getKind() != Factor::Number) {
-  //     llvm::errs() << "Right side of condition must be an identifier or a number.\n";
-  //   }
-  // };
-
-
-};
-}
-
-bool Sema::semantic(AST *Tree) {
-  if (!Tree)
-    return false; // If the input AST is not valid, return false indicating no errors
-
-  InputCheck Check; // Create an instance of the InputCheck class for semantic analysis
-  Tree->accept(Check); // Initiate the semantic analysis by traversing the AST using the accept function
-
-  return Check.hasError(); // Return the result of Check.hasError() indicating if any errors were detected during the analysis
-}
+#include "Sema.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace {
+// Checks that every variable is declared exactly once before it is used.
+class DeclCheck : public Analysis {
+  llvm::StringSet<> &Scope; // StringSet to store declared variables
+  bool HasError; // Flag to indicate if an error occurred
+
+  enum ErrorType { Twice, Not }; // Enum to represent error types: Twice - variable declared twice, Not - variable not declared
+
+  void error(ErrorType ET, llvm::StringRef V) {
+    // Function to report errors
+    llvm::errs() << "Variable " << V << " is "
+                 << (ET == Twice ? "already" : "not")
+                 << " declared\n";
+    HasError = true; // Set error flag to true
+    exit(0);
+  }
+
+public:
+  DeclCheck(llvm::StringSet<> &Scope) : Scope(Scope), HasError(false) {} // Constructor
+
+  virtual bool hasError() override { return HasError; } // Function to check if an error occurred
+
+  // Visit function for Factor nodes
+  virtual void visit(Factor &Node) override {
+    if (Node.getKind() == Factor::Ident) {
+      // Check if identifier is in the scope
+      if (Scope.find(Node.getVal()) == Scope.end())
+        error(Not, Node.getVal());
+    }
+  };
+
+  // Visit function for Assignment nodes; the destination itself is checked
+  // as a Factor by the traversal
+  virtual void visit(Assignment &Node) override {
+    Factor *dest = Node.getLeft();
+
+    if (dest && dest->getKind() == Factor::Number) {
+        llvm::errs() << "Assignment destination must be an identifier.";
+        HasError = true;
+    }
+  };
+
+  virtual void visit(Declaration &Node) override {
+    for (auto I = Node.begin(), E = Node.end(); I != E;
+         ++I) {
+      if (!Scope.insert(*I).second)
+        error(Twice, *I); // If the insertion fails (element already exists in Scope), report a "Twice" error
+    }
+  };
+};
+
+// Rejects division by a literal zero.
+class DivZeroCheck : public Analysis {
+  bool HasError; // Flag to indicate if an error occurred
+
+public:
+  DivZeroCheck() : HasError(false) {} // Constructor
+
+  virtual bool hasError() override { return HasError; }
+
+  virtual void visit(BinaryOp_Calculators &Node) override {
+    if (!Node.getLeft() || !Node.getRight())
+      HasError = true;
+
+    auto right = Node.getRight();
+    if (Node.getOperator() == BinaryOp_Calculators::Operator::Div && right) {
+      Factor *f = llvm::dyn_cast<Factor>(right);
+
+      if (f && f->getKind() == Factor::ValueKind::Number) {
+        int intval;
+        f->getVal().getAsInteger(10, intval);
+        if (intval == 0) {
+          llvm::errs() << "Division by zero is not allowed." << "\n";
+          HasError = true;
+        }
+      }
+    }
+  };
+};
+}
+
+bool Sema::semantic(AST *Tree) {
+  if (!Tree)
+    return false; // If the input AST is not valid, return false indicating no errors
+
+  // All checks and the analyses for code generation share a single walk
+  // over the tree
+  DeclCheck Decls(Declared);
+  DivZeroCheck DivZero;
+  Facts = TreeFacts();
+  FusedTraversal Traversal;
+  Traversal.addAnalysis(&Decls);
+  Traversal.addAnalysis(&DivZero);
+  Traversal.addAnalysis(&Facts.Nodes);
+  Traversal.addAnalysis(&Facts.Shape);
+
+  return Traversal.run(Tree); // Returns true if any of the analyses detected an error
+}
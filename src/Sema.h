@@ -1,12 +1,23 @@
-#ifndef SEMA_H
-#define SEMA_H
-
-#include "AST.h"
-#include "Lexer.h"
-
-class Sema {
-public:
-  bool semantic(AST *Tree);
-};
-
-#endif
\ No newline at end of file
+#ifndef SEMA_H
+#define SEMA_H
+
+#include "AST.h"
+#include "Analysis.h"
+#include "Lexer.h"
+#include "llvm/ADT/StringSet.h"
+
+class Sema {
+  llvm::StringSet<> Declared; // Variables declared so far
+  TreeFacts Facts;            // Facts about the tree checked last
+
+public:
+  // Checks the tree. The pieces of a program compiled piece by piece are
+  // checked in order with the same Sema, which remembers the declarations.
+  bool semantic(AST *Tree);
+
+  // Returns what the analyses that ran with the checks found out about the
+  // tree checked last, for generating its code.
+  const TreeFacts &getFacts() const { return Facts; }
+};
+
+#endif
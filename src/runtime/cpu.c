@@ -0,0 +1,22 @@
+/* CPU detection for programs compiled with --multiversion. The clones of
+   a function are compiled for the x86-64 microarchitecture levels, and the
+   program picks the highest level the CPU and the OS support at startup. */
+#include "gsmrt.h"
+
+int gsm_cpu_level(void)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("sse4.2") || !__builtin_cpu_supports("popcnt"))
+    return 1;
+  if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("bmi2") ||
+      !__builtin_cpu_supports("fma"))
+    return 2;
+  if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512bw") ||
+      !__builtin_cpu_supports("avx512dq") || !__builtin_cpu_supports("avx512vl"))
+    return 3;
+  return 4;
+#else
+  return 1;
+#endif
+}
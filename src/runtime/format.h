@@ -0,0 +1,45 @@
+#ifndef GSMRT_FORMAT_H
+#define GSMRT_FORMAT_H
+
+/* Decimal formatting shared by the runtime variants. */
+
+/* Longest line: "-2147483648\n". */
+#define GSM_LINE_MAX 12
+
+/* Two decimal digits for every value below 100. */
+static const char Digits[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Formats the value followed by a newline so that the text ends right before
+   End, and returns its first character. */
+static inline char *gsm_format(int Val, char *End)
+{
+  /* Format right to left, two digits per division. */
+  char *P = End;
+  unsigned U = Val < 0 ? 0u - (unsigned)Val : (unsigned)Val;
+
+  *--P = '\n';
+  while (U >= 100)
+  {
+    unsigned I = (U % 100) * 2;
+    U /= 100;
+    *--P = Digits[I + 1];
+    *--P = Digits[I];
+  }
+  if (U >= 10)
+  {
+    *--P = Digits[U * 2 + 1];
+    *--P = Digits[U * 2];
+  }
+  else
+    *--P = (char)('0' + U);
+  if (Val < 0)
+    *--P = '-';
+  return P;
+}
+
+#endif
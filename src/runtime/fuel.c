@@ -0,0 +1,12 @@
+/* The exit of programs compiled with -fuel when their budget runs out. */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gsmrt.h"
+
+void gsm_fuel_exhausted(void)
+{
+  gsm_flush();
+  fputs("gsm: fuel exhausted\n", stderr);
+  exit(GSM_FUEL_EXHAUSTED);
+}
@@ -0,0 +1,40 @@
+/* Runtime library linked into every GSM executable. Values are formatted
+   into a buffer that is written with a single write(2) when it is full and
+   when the program flushes it at exit. */
+#include <string.h>
+#include <unistd.h>
+
+#include "format.h"
+#include "gsmrt.h"
+
+#define GSM_BUFFER_SIZE 65536
+
+static char Buffer[GSM_BUFFER_SIZE];
+static unsigned Used;
+
+void gsm_flush(void)
+{
+  unsigned Done = 0;
+  while (Done < Used)
+  {
+    ssize_t N = write(1, Buffer + Done, Used - Done);
+    if (N <= 0)
+      break;
+    Done += (unsigned)N;
+  }
+  Used = 0;
+}
+
+/* Writes the value of an assignment to the standard output. */
+void gsm_write(int Val)
+{
+  char Tmp[GSM_LINE_MAX];
+  char *End = Tmp + sizeof(Tmp);
+  char *P = gsm_format(Val, End);
+
+  unsigned Len = (unsigned)(End - P);
+  if (Used + Len > GSM_BUFFER_SIZE)
+    gsm_flush();
+  memcpy(Buffer + Used, P, Len);
+  Used += Len;
+}
@@ -0,0 +1,46 @@
+#ifndef GSMRT_H
+#define GSMRT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Appends the decimal value and a newline to the output buffer. */
+void gsm_write(int Val);
+
+/* Writes out everything buffered so far. Generated code calls it before
+   main returns. */
+void gsm_flush(void);
+
+/* Writes the text to the standard output directly. Programs evaluated at
+   compile time call it once with their whole output instead of writing
+   values. */
+void gsm_write_text(const char *Text, uint64_t Len);
+
+/* Returns the x86-64 microarchitecture level (1 to 4) of the CPU, or 1 on
+   other targets. Multiversioned programs call it once at startup. */
+int gsm_cpu_level(void);
+
+/* Writes the counters of an instrumented program to the profile file.
+   Generated code calls it before main returns. */
+void gsm_profile_write(const char *Path, uint64_t Hash,
+                       const uint64_t *Counters, unsigned N);
+
+/* Exit status of a metered program that ran out of fuel, the one
+   timeout(1) uses. */
+#define GSM_FUEL_EXHAUSTED 124
+
+/* Writes out the output so far and exits with GSM_FUEL_EXHAUSTED.
+   Metered programs call it when their fuel runs out. */
+#ifdef __GNUC__
+__attribute__((noreturn, cold))
+#endif
+void gsm_fuel_exhausted(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
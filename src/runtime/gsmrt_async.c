@@ -0,0 +1,152 @@
+/* Asynchronous variant of the GSM runtime. gsm_write only appends the raw
+   value to a lock-free single-producer/single-consumer ring buffer. A writer
+   thread drains the ring, formats the values and writes them with writev(2),
+   so the program never waits for output I/O unless the ring is full.
+   gsm_flush stops the writer after everything has been written. */
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "format.h"
+#include "gsmrt.h"
+
+#define GSM_RING_SIZE (1u << 16) /* values; must be a power of two */
+#define GSM_RING_MASK (GSM_RING_SIZE - 1)
+#define GSM_CHUNK_SIZE 4096      /* bytes per writev buffer */
+#define GSM_CHUNKS 16            /* buffers per writev call */
+
+static int Ring[GSM_RING_SIZE];
+
+/* Head is only advanced by the program, Tail only by the writer thread.
+   They live on separate cache lines so the threads do not share one. */
+static _Alignas(64) atomic_uint Head;
+static _Alignas(64) atomic_uint Tail;
+static atomic_int Closing;
+
+static pthread_t Writer;
+static int State; /* 0: not started, 1: writer running, -1: synchronous */
+
+static char Chunks[GSM_CHUNKS][GSM_CHUNK_SIZE];
+
+static void writeAll(struct iovec *Iov, int Count)
+{
+  while (Count > 0)
+  {
+    ssize_t N = writev(1, Iov, Count);
+    if (N <= 0)
+      return;
+    /* Skip what was written and retry the rest. */
+    while (Count > 0 && (size_t)N >= Iov->iov_len)
+    {
+      N -= (ssize_t)Iov->iov_len;
+      ++Iov;
+      --Count;
+    }
+    if (Count > 0)
+    {
+      Iov->iov_base = (char *)Iov->iov_base + N;
+      Iov->iov_len -= (size_t)N;
+    }
+  }
+}
+
+static void *drain(void *Arg)
+{
+  (void)Arg;
+  unsigned T = atomic_load_explicit(&Tail, memory_order_relaxed);
+  for (;;)
+  {
+    unsigned H = atomic_load_explicit(&Head, memory_order_acquire);
+    if (H == T)
+    {
+      /* Closing is set after the last value was published, so the head read
+         after it is final. */
+      if (atomic_load_explicit(&Closing, memory_order_acquire))
+      {
+        if (T == atomic_load_explicit(&Head, memory_order_acquire))
+          return 0;
+        continue;
+      }
+      struct timespec Pause = {0, 50000};
+      nanosleep(&Pause, 0);
+      continue;
+    }
+
+    /* Format as many values as fit into the chunks, then write them all
+       with one system call. */
+    struct iovec Iov[GSM_CHUNKS];
+    int Count = 0;
+    while (T != H && Count < GSM_CHUNKS)
+    {
+      char *Buf = Chunks[Count];
+      unsigned Len = 0;
+      while (T != H && Len + GSM_LINE_MAX <= GSM_CHUNK_SIZE)
+      {
+        char Tmp[GSM_LINE_MAX];
+        char *End = Tmp + sizeof(Tmp);
+        char *P = gsm_format(Ring[T & GSM_RING_MASK], End);
+        memcpy(Buf + Len, P, (size_t)(End - P));
+        Len += (unsigned)(End - P);
+        ++T;
+      }
+      Iov[Count].iov_base = Buf;
+      Iov[Count].iov_len = Len;
+      ++Count;
+    }
+
+    /* The slots can be reused as soon as their values are formatted. */
+    atomic_store_explicit(&Tail, T, memory_order_release);
+    writeAll(Iov, Count);
+  }
+}
+
+static void start(void)
+{
+  atomic_store_explicit(&Closing, 0, memory_order_relaxed);
+  if (pthread_create(&Writer, 0, drain, 0) == 0)
+  {
+    State = 1;
+    atexit(gsm_flush);
+  }
+  else
+    State = -1;
+}
+
+/* Queues the value of an assignment for the writer thread. */
+void gsm_write(int Val)
+{
+  if (State == 0)
+    start();
+
+  if (State < 0)
+  {
+    /* No writer thread: write the value directly. */
+    char Tmp[GSM_LINE_MAX];
+    char *End = Tmp + sizeof(Tmp);
+    struct iovec Iov;
+    Iov.iov_base = gsm_format(Val, End);
+    Iov.iov_len = (size_t)(End - (char *)Iov.iov_base);
+    writeAll(&Iov, 1);
+    return;
+  }
+
+  unsigned H = atomic_load_explicit(&Head, memory_order_relaxed);
+  while (H - atomic_load_explicit(&Tail, memory_order_acquire) == GSM_RING_SIZE)
+    sched_yield(); /* ring is full, let the writer catch up */
+  Ring[H & GSM_RING_MASK] = Val;
+  atomic_store_explicit(&Head, H + 1, memory_order_release);
+}
+
+void gsm_flush(void)
+{
+  if (State != 1)
+    return;
+  atomic_store_explicit(&Closing, 1, memory_order_release);
+  pthread_join(Writer, 0);
+  State = 0;
+}
@@ -0,0 +1,21 @@
+/* Writes the counters of a program compiled with -profile-generate. The
+   profile is a text file: a header with the shape hash of the program and
+   the number of counters, then one count per line. */
+#include <stdio.h>
+
+#include "gsmrt.h"
+
+void gsm_profile_write(const char *Path, uint64_t Hash,
+                       const uint64_t *Counters, unsigned N)
+{
+  FILE *F = fopen(Path, "w");
+  if (!F)
+  {
+    fprintf(stderr, "gsm: cannot write profile %s\n", Path);
+    return;
+  }
+  fprintf(F, "gsm-profile %llu %u\n", (unsigned long long)Hash, N);
+  for (unsigned I = 0; I < N; ++I)
+    fprintf(F, "%llu\n", (unsigned long long)Counters[I]);
+  fclose(F);
+}
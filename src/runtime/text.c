@@ -0,0 +1,17 @@
+/* The output of programs evaluated at compile time with -precompute. The
+   whole output is a constant that is written with a single write(2). */
+#include <unistd.h>
+
+#include "gsmrt.h"
+
+void gsm_write_text(const char *Text, uint64_t Len)
+{
+  while (Len)
+  {
+    ssize_t N = write(1, Text, Len);
+    if (N <= 0)
+      break;
+    Text += N;
+    Len -= (uint64_t)N;
+  }
+}
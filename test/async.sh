@@ -0,0 +1,30 @@
+#!/bin/sh
+# An executable linked with --async-output writes the values in program
+# order and all of them by the time main returns, also when the program
+# writes many times more values than the ring buffer holds. The JIT has no
+# asynchronous runtime, so --run rejects the flag.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/a.gsm" <<'GSM'
+int i = 0;
+loopc i < 300000: begin
+i = i + 1;
+end
+GSM
+
+"$GSM" --files "$DIR/a.gsm" --link --async-output -o "$DIR/a" || exit 1
+"$DIR/a" > "$DIR/out" || exit 1
+seq 1 300000 > "$DIR/expected"
+if ! cmp -s "$DIR/out" "$DIR/expected"; then
+  echo "the asynchronous output differs from 1..300000:"; head -3 "$DIR/out"; exit 1
+fi
+"$GSM" --files "$DIR/a.gsm" --link -o "$DIR/s" || exit 1
+"$DIR/s" > "$DIR/sync" || exit 1
+if ! cmp -s "$DIR/out" "$DIR/sync"; then
+  echo "the asynchronous and the synchronous output differ"; exit 1
+fi
+if "$GSM" --files "$DIR/a.gsm" --run --async-output > /dev/null 2>&1; then
+  echo "--async-output was accepted with --run"; exit 1
+fi
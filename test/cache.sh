@@ -0,0 +1,27 @@
+#!/bin/sh
+# A flag value given as the next argument is part of the cache key: changing
+# it between two cached runs must not return the output of the first.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/c.gsm" <<'GSM'
+int i = 0;
+loopc i < 10: begin
+i = i + 1;
+end
+GSM
+
+Plain=$("$GSM" --cache-dir="$DIR/cache" -fuel 0 -precompute=false --files "$DIR/c.gsm") || exit 1
+Metered=$("$GSM" --cache-dir="$DIR/cache" -fuel 5 -precompute=false --files "$DIR/c.gsm") || exit 1
+Joined=$("$GSM" --cache-dir="$DIR/cache" -fuel=5 -precompute=false --files "$DIR/c.gsm") || exit 1
+
+if echo "$Plain" | grep -q gsm_fuel_exhausted; then
+  echo "-fuel 0 metered the program"; exit 1
+fi
+if ! echo "$Metered" | grep -q gsm_fuel_exhausted; then
+  echo "-fuel 5 returned the cached output of -fuel 0"; exit 1
+fi
+if [ "$Metered" != "$Joined" ]; then
+  echo "-fuel 5 and -fuel=5 gave different outputs"; exit 1
+fi
@@ -0,0 +1,36 @@
+#!/bin/sh
+# The fast tier skips the verifier and the passes, and the JIT compiles for
+# the small code model. The program must still write the same output as
+# with the default flags, in the JIT, on several threads and as an
+# executable.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/f.gsm" <<'GSM'
+int i = 0;
+int s = 0;
+loopc i < 20: begin
+s = s + i ^ 2 % 7;
+i = i + 1;
+end
+int a = 3;
+if s > 100 and a / 3 == 1: begin
+a = s;
+end else: begin
+a = 0 - s;
+end
+GSM
+
+Expected=$("$GSM" --files "$DIR/f.gsm" --run | tr '\n' ' ') || exit 1
+for Flags in "" "-O2" "-threads=2 -split-functions=5"; do
+  Out=$("$GSM" --files "$DIR/f.gsm" --run --fast-compile $Flags | tr '\n' ' ')
+  if [ "$Out" != "$Expected" ]; then
+    echo "--fast-compile $Flags wrote '$Out' instead of '$Expected'"; exit 1
+  fi
+done
+"$GSM" --files "$DIR/f.gsm" --link --fast-compile -o "$DIR/f" || exit 1
+Out=$("$DIR/f" | tr '\n' ' ')
+if [ "$Out" != "$Expected" ]; then
+  echo "the --fast-compile executable wrote '$Out' instead of '$Expected'"; exit 1
+fi
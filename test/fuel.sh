@@ -0,0 +1,53 @@
+#!/bin/sh
+# A metered program that runs out of fuel writes the output it has produced
+# so far and exits with status 124, linked or run in the JIT, also with the
+# runtime linked into the module. The --inline-runtime checks need the runtime bitcode, which is
+# only built with clang; RUNTIME_BC names another one.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/f.gsm" <<'GSM'
+int i = 0;
+loopc i < 10: begin
+i = i + 1;
+end
+GSM
+
+check() {
+  "$GSM" --files "$DIR/f.gsm" -fuel 5 --link -o "$DIR/f" "$@" || exit 1
+  "$DIR/f" > "$DIR/out" 2>/dev/null
+  Status=$?
+  verify "$@"
+  "$GSM" --files "$DIR/f.gsm" -fuel 5 --run "$@" > "$DIR/out" 2>/dev/null
+  Status=$?
+  verify --run "$@"
+}
+
+verify() {
+  Out=$(tr '\n' ' ' < "$DIR/out")
+  if [ "$Status" != 124 ]; then
+    echo "exit status $Status instead of 124 with flags '$*'"; exit 1
+  fi
+  if [ "$Out" != "1 2 3 4 " ]; then
+    echo "wrong output with flags '$*': $Out"; exit 1
+  fi
+}
+
+check
+check -O2
+
+# The statements before the loop cost one unit, the ten iterations one each.
+"$GSM" --files "$DIR/f.gsm" -fuel 11 --link -o "$DIR/f" || exit 1
+Out=$("$DIR/f" | tr '\n' ' ') || { echo "-fuel 11 ran out of fuel"; exit 1; }
+if [ "$Out" != "1 2 3 4 5 6 7 8 9 10 " ]; then
+  echo "wrong output with -fuel 11: $Out"; exit 1
+fi
+if "$GSM" --files "$DIR/f.gsm" -fuel 10 --link -o "$DIR/f" && "$DIR/f" > /dev/null 2>&1; then
+  echo "-fuel 10 did not run out of fuel"; exit 1
+fi
+BC=${RUNTIME_BC:+-runtime-bc=$RUNTIME_BC}
+if "$GSM" --files "$DIR/f.gsm" --inline-runtime $BC -c -o "$DIR/f.o" 2>/dev/null; then
+  check --inline-runtime $BC
+  check --inline-runtime $BC -O2
+fi
@@ -0,0 +1,35 @@
+#!/bin/sh
+# A program with the runtime linked into the module writes the same output
+# as one calling the runtime library, in the JIT and as an executable. The
+# checks need the runtime bitcode, which is only built with clang;
+# RUNTIME_BC names another one.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/i.gsm" <<'GSM'
+int i = 0;
+int s = 0;
+loopc i < 5: begin
+s = s + i * i;
+i = i + 1;
+end
+GSM
+
+BC=${RUNTIME_BC:+-runtime-bc=$RUNTIME_BC}
+if ! "$GSM" --files "$DIR/i.gsm" --inline-runtime $BC -c -o "$DIR/i.o" 2>/dev/null; then
+  echo "no runtime bitcode, skipping"; exit 0
+fi
+
+Expected=$("$GSM" --files "$DIR/i.gsm" --run | tr '\n' ' ') || exit 1
+for Flags in "" "-O2"; do
+  Out=$("$GSM" --files "$DIR/i.gsm" --run --inline-runtime $BC $Flags | tr '\n' ' ')
+  if [ "$Out" != "$Expected" ]; then
+    echo "--run --inline-runtime $Flags wrote '$Out' instead of '$Expected'"; exit 1
+  fi
+  "$GSM" --files "$DIR/i.gsm" --link --inline-runtime $BC $Flags -o "$DIR/i" || exit 1
+  Out=$("$DIR/i" | tr '\n' ' ')
+  if [ "$Out" != "$Expected" ]; then
+    echo "--link --inline-runtime $Flags wrote '$Out' instead of '$Expected'"; exit 1
+  fi
+done
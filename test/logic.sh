@@ -0,0 +1,35 @@
+#!/bin/sh
+# and/or evaluate their right-hand side only if the left one does not
+# decide the result, so a guarded division by zero never runs, in ifs and
+# in loop conditions alike.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/l.gsm" <<'GSM'
+int x = 0;
+int y = 10;
+int r = 0;
+if x != 0 and y / x > 3: begin
+r = 1;
+end else: begin
+r = 2;
+end
+if x == 0 or y % x > 3: begin
+r = r + 10;
+end
+loopc x > 0 and y / x > 3: begin
+r = 0;
+end
+x = 2;
+if x != 0 and y / x > 3: begin
+r = r + 100;
+end
+GSM
+
+for Flags in "-O0" "-O2" "-precompute"; do
+  Out=$("$GSM" --files "$DIR/l.gsm" --run $Flags | tr '\n' ' ')
+  if [ "$Out" != "2 12 2 112 " ]; then
+    echo "wrong output with $Flags: $Out"; exit 1
+  fi
+done
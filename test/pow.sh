@@ -0,0 +1,35 @@
+#!/bin/sh
+# ^ with an exponent known only at run time goes through gsm.pow, where
+# exponents below 1 give 1 and results wrap around. The JIT at -O0 and -O2
+# and the evaluation in the compiler agree on every exponent. A constant
+# exponent takes O(log n) multiplies.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/p.gsm" <<'GSM'
+int b = 3;
+int e = 0 - 2;
+int p = 0;
+loopc e < 13: begin
+p = b ^ e;
+e = e + 1;
+end
+int c = 0 - 2;
+int n = 31;
+c = c ^ n;
+c = p ^ 100000;
+GSM
+
+Expected="1 -1 1 0 1 1 3 2 9 3 27 4 81 5 243 6 729 7 2187 8 6561 9 19683 10 59049 11 177147 12 531441 13 -2147483648 -1424898559"
+for Flags in "-O0" "-O2" "-precompute"; do
+  Out=$("$GSM" --files "$DIR/p.gsm" --run $Flags | tr '\n' ' ' | sed 's/ $//')
+  if [ "$Out" != "$Expected" ]; then
+    echo "wrong powers with $Flags:"; echo "$Out"; exit 1
+  fi
+done
+
+Muls=$("$GSM" --files "$DIR/p.gsm" | grep -c " mul ")
+if [ "$Muls" -gt 64 ]; then
+  echo "p ^ 100000 took $Muls multiplies"; exit 1
+fi
@@ -0,0 +1,60 @@
+#!/bin/sh
+# A precomputed program writes its output as one text and prints the same
+# as the program computed at run time; past a budget, or on a division by
+# zero, it is compiled as usual.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/p.gsm" <<'GSM'
+int a = 1;
+int b = 2;
+int c = 0;
+a = a + b;
+b = a * b;
+loopc c < 5: begin
+c = c + 1;
+a = a + c;
+end
+if a > b: begin
+b = a - b;
+end else: begin
+b = b - a;
+end
+int d = a + b + c;
+d = d * 2;
+a = d % 7;
+GSM
+
+"$GSM" --files "$DIR/p.gsm" -precompute=false --run > "$DIR/plain" || exit 1
+
+for Flags in "" "-precompute-budget=5" "-precompute-max-output=4"; do
+  "$GSM" --files "$DIR/p.gsm" -precompute $Flags > "$DIR/p.ll" || exit 1
+  if [ -z "$Flags" ]; then
+    if ! grep -q "call void @gsm_write_text" "$DIR/p.ll"; then
+      echo "program was not precomputed"; exit 1
+    fi
+  elif grep -q "call void @gsm_write_text" "$DIR/p.ll"; then
+    echo "program was precomputed despite $Flags"; exit 1
+  fi
+  "$GSM" --files "$DIR/p.gsm" -precompute $Flags --run > "$DIR/out" || exit 1
+  if ! cmp -s "$DIR/plain" "$DIR/out"; then
+    echo "wrong output of --run with '$Flags': $(cat "$DIR/out")"; exit 1
+  fi
+  "$GSM" --files "$DIR/p.gsm" -precompute $Flags --link -o "$DIR/p" || exit 1
+  "$DIR/p" > "$DIR/out" || exit 1
+  if ! cmp -s "$DIR/plain" "$DIR/out"; then
+    echo "wrong output of --link with '$Flags': $(cat "$DIR/out")"; exit 1
+  fi
+done
+
+cat > "$DIR/z.gsm" <<'GSM'
+int a = 3;
+a = a - 3;
+int b = 7;
+b = b / a;
+GSM
+"$GSM" --files "$DIR/z.gsm" -precompute > "$DIR/z.ll" || exit 1
+if grep -q "call void @gsm_write_text" "$DIR/z.ll"; then
+  echo "division by zero was precomputed"; exit 1
+fi
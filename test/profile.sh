@@ -0,0 +1,71 @@
+#!/bin/sh
+# A profile written by an instrumented program, run in the JIT or linked,
+# weights the branches of the same program without changing its output. A
+# profile of another program is ignored.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/p.gsm" <<'GSM'
+int i = 0;
+int e = 0;
+loopc i < 20: begin
+i = i + 1;
+e = e + i % 5;
+end
+if e > 3: begin
+e = e + 1;
+end else: begin
+e = 0;
+end
+GSM
+
+"$GSM" --files "$DIR/p.gsm" --run > "$DIR/plain" || exit 1
+
+check() {
+  if [ "$(head -n 1 "$DIR/p.prof" | cut -d ' ' -f 1)" != gsm-profile ]; then
+    echo "no profile written by $1"; exit 1
+  fi
+  if [ "$(tail -n 4 "$DIR/p.prof" | tr '\n' ' ')" != "1 20 1 0 " ]; then
+    echo "wrong counts written by $1: $(cat "$DIR/p.prof")"; exit 1
+  fi
+  "$GSM" --files "$DIR/p.gsm" -profile-use="$DIR/p.prof" > "$DIR/p.ll" || exit 1
+  if ! grep -q '!"branch_weights", i32 21, i32 2' "$DIR/p.ll"; then
+    echo "loop not weighted by the profile of $1"; exit 1
+  fi
+  for Flags in "-O0" "-O2"; do
+    "$GSM" --files "$DIR/p.gsm" -profile-use="$DIR/p.prof" --run $Flags \
+      > "$DIR/used" || exit 1
+    if ! cmp -s "$DIR/plain" "$DIR/used"; then
+      echo "profile of $1 changed the output with $Flags"; exit 1
+    fi
+  done
+}
+
+"$GSM" --files "$DIR/p.gsm" -profile-generate="$DIR/p.prof" --run \
+  > "$DIR/out" || exit 1
+if ! cmp -s "$DIR/plain" "$DIR/out"; then
+  echo "instrumentation changed the output of --run"; exit 1
+fi
+check --run
+
+rm -f "$DIR/p.prof"
+"$GSM" --files "$DIR/p.gsm" -profile-generate="$DIR/p.prof" --link \
+  -o "$DIR/p" || exit 1
+"$DIR/p" > "$DIR/out" || exit 1
+if ! cmp -s "$DIR/plain" "$DIR/out"; then
+  echo "instrumentation changed the output of --link"; exit 1
+fi
+check --link
+
+# One more if changes the shape of the program.
+cat "$DIR/p.gsm" - > "$DIR/q.gsm" <<'GSM'
+if e > 1: begin
+e = 1;
+end
+GSM
+"$GSM" --files "$DIR/q.gsm" -profile-use="$DIR/p.prof" > "$DIR/q.ll" \
+  2> "$DIR/err" || exit 1
+if grep -q branch_weights "$DIR/q.ll" || ! grep -q "does not match" "$DIR/err"; then
+  echo "profile of another program was used"; exit 1
+fi
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Optimization remarks refer to the generated loop, with the default flags
+# and with compile-time evaluation requested.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/r.gsm" <<'GSM'
+int i = 0;
+int s = 0;
+loopc i < 10: begin
+s = s + i;
+i = i + 1;
+end
+GSM
+
+for Flags in "" "-precompute"; do
+  Remarks=$("$GSM" -O2 -Rpass=loop-unroll $Flags --files "$DIR/r.gsm" 2>&1 >/dev/null) || exit 1
+  if ! echo "$Remarks" | grep -q "r.gsm:3:1: remark: completely unrolled loop with 10 iterations"; then
+    echo "no unroll remark with flags '$Flags':"; echo "$Remarks"; exit 1
+  fi
+  Remarks=$("$GSM" -O2 -pass-remarks=.* $Flags --files "$DIR/r.gsm" 2>&1 >/dev/null) || exit 1
+  if ! echo "$Remarks" | grep -q "completely unrolled"; then
+    echo "no -pass-remarks output with flags '$Flags':"; echo "$Remarks"; exit 1
+  fi
+done
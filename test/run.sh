@@ -0,0 +1,36 @@
+#!/bin/sh
+# --run compiles the program in the JIT and writes the same output as the
+# linked executable at every optimization level, exiting with status 0.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/r.gsm" <<'GSM'
+int i = 0;
+int f = 1;
+loopc i < 10: begin
+i = i + 1;
+f = f * i % 1000;
+end
+int g = f - 7;
+if g > 500: begin
+g = g / 2;
+end else: begin
+g = g * 3;
+end
+GSM
+
+"$GSM" --files "$DIR/r.gsm" --link -o "$DIR/r" || exit 1
+Expected=$("$DIR/r" | tr '\n' ' ') || exit 1
+if [ "$Expected" != "1 1 2 2 3 6 4 24 5 120 6 720 7 40 8 320 9 880 10 800 396 " ]; then
+  echo "wrong output of the executable: $Expected"; exit 1
+fi
+for Level in -O0 -O1 -O2 -O3; do
+  Out=$("$GSM" --files "$DIR/r.gsm" --run $Level | tr '\n' ' ')
+  if [ "$Out" != "$Expected" ]; then
+    echo "--run $Level wrote '$Out' instead of '$Expected'"; exit 1
+  fi
+  if ! "$GSM" --files "$DIR/r.gsm" --run $Level > /dev/null; then
+    echo "--run $Level failed"; exit 1
+  fi
+done
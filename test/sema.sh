@@ -0,0 +1,31 @@
+#!/bin/sh
+# The semantic checks run in one traversal: the errors of both checks are
+# reported in program order, and a division by zero does not stop the
+# traversal. An undeclared variable still ends the compilation at once.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/e.gsm" <<'GSM'
+int a = 4 / 0;
+int b = a / 0;
+int c = d;
+int e = 1 / 0;
+GSM
+
+Errors=$("$GSM" --files "$DIR/e.gsm" 2>&1 >/dev/null)
+Expected="Division by zero is not allowed.
+Division by zero is not allowed.
+Variable d is not declared"
+if [ "$Errors" != "$Expected" ]; then
+  echo "wrong errors:"; echo "$Errors"; exit 1
+fi
+
+cat > "$DIR/z.gsm" <<'GSM'
+int a = 4 / 0;
+int b = a / 0;
+GSM
+
+if "$GSM" --files "$DIR/z.gsm" > /dev/null 2>&1; then
+  echo "a division by zero was accepted"; exit 1
+fi
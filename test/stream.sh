@@ -0,0 +1,56 @@
+#!/bin/sh
+# Compiling a program in chunks gives the same output as compiling it
+# whole, for any chunk size, also when variables are declared in one chunk
+# and used in later ones.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/s.gsm" <<'GSM'
+int a = 1;
+int b = 2;
+int c = 0;
+a = a + b;
+b = a * b;
+loopc c < 5: begin
+c = c + 1;
+a = a + c;
+end
+if a > b: begin
+b = a - b;
+end else: begin
+b = b - a;
+end
+int d = a + b + c;
+d = d * 2;
+a = d % 7;
+GSM
+
+"$GSM" --files "$DIR/s.gsm" --run > "$DIR/plain" || exit 1
+if [ "$(tr '\n' ' ' < "$DIR/plain")" != "3 6 1 4 2 6 3 9 4 13 5 18 12 70 0 " ]; then
+  echo "wrong output: $(cat "$DIR/plain")"; exit 1
+fi
+
+for Size in 1 2 3 100; do
+  for Flags in "-O0" "-O2"; do
+    "$GSM" --files "$DIR/s.gsm" -stream $Size --run $Flags > "$DIR/out" || exit 1
+    if ! cmp -s "$DIR/plain" "$DIR/out"; then
+      echo "-stream $Size --run $Flags: $(cat "$DIR/out")"; exit 1
+    fi
+    "$GSM" --files "$DIR/s.gsm" -stream $Size --link $Flags -o "$DIR/s" || exit 1
+    "$DIR/s" > "$DIR/out" || exit 1
+    if ! cmp -s "$DIR/plain" "$DIR/out"; then
+      echo "-stream $Size --link $Flags: $(cat "$DIR/out")"; exit 1
+    fi
+    rm -f "$DIR/s.o"
+    "$GSM" --files "$DIR/s.gsm" -stream $Size -c $Flags -o "$DIR/s.o" || exit 1
+    if [ ! -s "$DIR/s.o" ]; then
+      echo "-stream $Size -c $Flags wrote no object"; exit 1
+    fi
+  done
+done
+
+# Without an object or a JIT there is nothing to stream into.
+if "$GSM" --files "$DIR/s.gsm" -stream 2 > /dev/null 2>&1; then
+  echo "-stream without -c, --link or --run was accepted"; exit 1
+fi
@@ -0,0 +1,32 @@
+#!/bin/sh
+# A short if/elif chain comparing one variable with literals becomes a
+# switch, even though its arms are cheap enough to be lowered to selects.
+GSM=$1
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+cat > "$DIR/s.gsm" <<'GSM'
+int op = 2;
+int x = 0;
+if op == 1: begin
+x = 10;
+end elif op == 2: begin
+x = 20;
+end elif op == 3: begin
+x = 30;
+end else: begin
+x = 0;
+end
+GSM
+
+IR=$("$GSM" --files "$DIR/s.gsm") || exit 1
+if ! echo "$IR" | grep -q "switch i32"; then
+  echo "the dispatch chain is not a switch:"; echo "$IR"; exit 1
+fi
+if echo "$IR" | grep -q " select "; then
+  echo "the dispatch chain evaluates every arm with selects:"; echo "$IR"; exit 1
+fi
+Out=$("$GSM" --files "$DIR/s.gsm" --run | tr '\n' ' ') || exit 1
+if [ "$Out" != "20 " ]; then
+  echo "wrong output: $Out"; exit 1
+fi